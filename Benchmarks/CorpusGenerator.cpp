@@ -0,0 +1,188 @@
+#include "CorpusGenerator.h"
+
+#include <sstream>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+namespace {
+    
+    //! the operators cycled through by the classes, with the kind of signature they take
+    struct OperatorSignature {
+        const char* mName;
+        enum Kind { Arithmetic, Assignment, Comparison } mKind;
+    };
+    
+    const OperatorSignature sOperators[] = {
+        { "operator+", OperatorSignature::Arithmetic }, { "operator-", OperatorSignature::Arithmetic },
+        { "operator*", OperatorSignature::Arithmetic }, { "operator/", OperatorSignature::Arithmetic },
+        { "operator==", OperatorSignature::Comparison }, { "operator<", OperatorSignature::Comparison },
+        { "operator+=", OperatorSignature::Assignment }, { "operator-=", OperatorSignature::Assignment },
+        { "operator*=", OperatorSignature::Assignment }, { "operator/=", OperatorSignature::Assignment }
+    };
+    const size_t sNumOperators = sizeof( sOperators ) / sizeof( sOperators[0] );
+    
+    const char* sBuiltinTypes[] = { "float", "double", "int", "unsigned int", "bool", "short" };
+    const size_t sNumBuiltinTypes = sizeof( sBuiltinTypes ) / sizeof( sBuiltinTypes[0] );
+
+}
+
+//! returns the header included by every header of the corpus
+std::string CorpusGenerator::generateCommonHeader() const
+{
+    stringstream code;
+    code << "#pragma once" << endl << endl;
+    code << "// the generated sources use the cinder namespace" << endl;
+    code << "namespace ci {}" << endl << endl;
+    code << "namespace bench {" << endl << endl;
+    code << "\t" << "class Vec2 {" << endl;
+    code << "\t" << "public:" << endl;
+    code << "\t\t" << "Vec2() : x( 0 ), y( 0 ) {}" << endl;
+    code << "\t\t" << "Vec2( float x, float y ) : x( x ), y( y ) {}" << endl;
+    code << "\t\t" << "float length() const { return x * x + y * y; }" << endl;
+    code << "\t\t" << "Vec2 operator+( const Vec2 &other ) const { return Vec2( x + other.x, y + other.y ); }" << endl;
+    code << "\t\t" << "bool operator==( const Vec2 &other ) const { return x == other.x && y == other.y; }" << endl;
+    code << "\t\t" << "float x, y;" << endl;
+    code << "\t" << "};" << endl << endl;
+    code << "}" << endl;
+    return code.str();
+}
+
+//! returns the code of a header, the index keeps its names unique in the corpus
+std::string CorpusGenerator::generateHeader( size_t index ) const
+{
+    string suffix = to_string( index );
+    stringstream code;
+    code << "#pragma once" << endl << endl;
+    code << "#include \"Common.h\"" << endl << endl;
+    
+    // the outer namespace keeps the headers apart, the nested ones exercise the scopes
+    code << "namespace bench { namespace h" << suffix << " {";
+    for( size_t depth = 1; depth <= mNamespaceDepth; depth++ ){
+        code << " namespace n" << depth << " {";
+    }
+    code << endl << endl;
+    
+    for( size_t e = 0; e < mEnums; e++ ){
+        string name = "Mode" + suffix + "_" + to_string( e );
+        code << "enum " << name << " { ";
+        for( size_t value = 0; value < 8; value++ ){
+            code << ( value ? ", " : "" ) << "MODE" << suffix << "_" << e << "_" << value;
+        }
+        code << " };" << endl;
+    }
+    if( mEnums ) code << endl;
+    
+    for( size_t t = 0; t < mTemplates; t++ ){
+        string name = "Box" + suffix + "_" + to_string( t );
+        code << "template<typename T>" << endl;
+        code << "class " << name << " {" << endl;
+        code << "public:" << endl;
+        code << "\t" << name << "() : mValue() {}" << endl;
+        code << "\t" << "explicit " << name << "( const T &value ) : mValue( value ) {}" << endl;
+        code << "\t" << "const T& getValue() const { return mValue; }" << endl;
+        code << "\t" << "void setValue( const T &value ) { mValue = value; }" << endl;
+        code << "\t" << "bool isEqual( const " << name << " &other ) const { return mValue == other.mValue; }" << endl;
+        code << "protected:" << endl;
+        code << "\t" << "T mValue;" << endl;
+        code << "};" << endl << endl;
+    }
+    
+    for( size_t c = 0; c < mClasses; c++ ){
+        string name     = "Class" + suffix + "_" + to_string( c );
+        string previous = c ? "Class" + suffix + "_" + to_string( c - 1 ) : "Vec2";
+        code << "class " << name << " {" << endl;
+        code << "public:" << endl;
+        code << "\t" << name << "() : mX( 0 ), mY( 0 ) {}" << endl;
+        code << "\t" << name << "( float x, float y ) : mX( x ), mY( y ) {}" << endl;
+        
+        // the accessors are bound as properties
+        code << "\t" << "float getX() const { return mX; }" << endl;
+        code << "\t" << "void setX( float x ) { mX = x; }" << endl;
+        code << "\t" << "float getY() const { return mY; }" << endl;
+        code << "\t" << "void setY( float y ) { mY = y; }" << endl;
+        
+        // the templates instantiated with the class compare their values, the operators only declare it past their fifth
+        if( mOperators <= 4 ){
+            code << "\t" << "bool operator==( const " << name << " &other ) const { return mX == other.mX && mY == other.mY; }" << endl;
+        }
+        
+        // cycle through the signatures the Visitor handles differently, defined so the bindings link
+        for( size_t m = 0; m < mMethods; m++ ){
+            string method = "method" + to_string( m );
+            code << "\t";
+            switch( m % 6 ){
+                case 0: code << "float " << method << "( float a, int b ) const { return a + b; }"; break;
+                case 1: code << "void " << method << "( const " << previous << " &other ) {}"; break;
+                case 2: code << "static int " << method << "( int a = 0 ) { return a; }"; break;
+                case 3: code << "bool " << method << "() const { return mX < mY; }"; break;
+                case 4: code << "double " << method << "( double a, double b, double c ) { return a * b + c; }"; break;
+                case 5: code << "const Vec2& " << method << "() const { return mPosition; }"; break;
+            }
+            code << endl;
+        }
+        
+        // the operators are overloaded on their argument type once the list is exhausted
+        for( size_t o = 0; o < mOperators; o++ ){
+            const OperatorSignature &op = sOperators[o % sNumOperators];
+            size_t overload = ( o / sNumOperators ) % ( sNumBuiltinTypes + 2 );
+            string argument = overload == 0 ? "const " + name + " &" : ( overload == 1 ? "const Vec2 &" : sBuiltinTypes[overload - 2] );
+            code << "\t";
+            switch( op.mKind ){
+                case OperatorSignature::Arithmetic: code << name << " " << op.mName << "( " << argument << " other ) const { return *this; }"; break;
+                case OperatorSignature::Assignment: code << name << "& " << op.mName << "( " << argument << " other ) { return *this; }"; break;
+                case OperatorSignature::Comparison: code << "bool " << op.mName << "( " << argument << " other ) const { return false; }"; break;
+            }
+            code << endl;
+        }
+        code << "protected:" << endl;
+        code << "\t" << "float mX, mY;" << endl;
+        code << "\t" << "Vec2 mPosition;" << endl;
+        code << "};" << endl << endl;
+    }
+    
+    // the typedefs instantiate the templates with the builtin types, then with the classes of the header
+    for( size_t t = 0; t < mTypedefs && mTemplates; t++ ){
+        size_t templateIndex    = t % mTemplates;
+        size_t argumentIndex    = t / mTemplates;
+        size_t numArguments     = sNumBuiltinTypes + mClasses;
+        size_t argument         = argumentIndex % numArguments;
+        string argumentType     = argument < sNumBuiltinTypes ? sBuiltinTypes[argument] : "Class" + suffix + "_" + to_string( argument - sNumBuiltinTypes );
+        code << "typedef Box" << suffix << "_" << templateIndex << "<" << argumentType << "> Box" << suffix << "_" << templateIndex << "_" << argumentIndex << ";" << endl;
+    }
+    if( mTypedefs && mTemplates ) code << endl;
+    
+    for( size_t f = 0; f < mFunctions; f++ ){
+        string argument = mClasses ? "const Class" + suffix + "_" + to_string( f % mClasses ) + " &object" : "const Vec2 &object";
+        code << "inline float function" << suffix << "_" << f << "( float a, " << argument << " ) { return a; }" << endl;
+    }
+    if( mFunctions ) code << endl;
+    
+    for( size_t depth = 0; depth < mNamespaceDepth + 2; depth++ ){
+        code << "}";
+    }
+    code << " // namespace" << endl;
+    return code.str();
+}
+
+//! writes count headers and their common header in the directory and returns the paths of the headers
+std::vector<std::string> CorpusGenerator::write( const std::string &directory, size_t count, const std::string &prefix ) const
+{
+    fs::create_directories( directory );
+    
+    ofstream common( ( fs::path( directory ) / "Common.h" ).c_str() );
+    common << generateCommonHeader();
+    
+    vector<string> headers;
+    for( size_t i = 0; i < count; i++ ){
+        fs::path path = fs::path( directory ) / ( prefix + to_string( i ) + ".h" );
+        ofstream header( path.c_str() );
+        header << generateHeader( i );
+        headers.push_back( path.string() );
+    }
+    return headers;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//! Writes synthetic headers exercising every declaration the Visitor binds. The headers only include
+//! the common header of the corpus so they parse without any system or library include path, and
+//! every function is defined inline so the generated bindings link without any other source.
+class CorpusGenerator {
+public:
+    CorpusGenerator() : mClasses( 4 ), mMethods( 8 ), mTemplates( 1 ), mTypedefs( 2 ), mEnums( 2 ), mNamespaceDepth( 1 ), mOperators( 2 ), mFunctions( 4 ) {}
+    
+    //! the counts are per header, the methods and operators are per class
+    CorpusGenerator& classes( size_t count ){ mClasses = count; return *this; }
+    CorpusGenerator& methods( size_t count ){ mMethods = count; return *this; }
+    CorpusGenerator& templates( size_t count ){ mTemplates = count; return *this; }
+    //! typedefs of template instantiations, the Visitor binds each of them as a type
+    CorpusGenerator& typedefs( size_t count ){ mTypedefs = count; return *this; }
+    CorpusGenerator& enums( size_t count ){ mEnums = count; return *this; }
+    //! the namespaces nested in the namespace of the header
+    CorpusGenerator& namespaceDepth( size_t depth ){ mNamespaceDepth = depth; return *this; }
+    //! the operators are overloaded on 8 argument types, past 80 operators the overloads repeat
+    CorpusGenerator& operators( size_t count ){ mOperators = count; return *this; }
+    CorpusGenerator& functions( size_t count ){ mFunctions = count; return *this; }
+    
+    size_t getClasses() const { return mClasses; }
+    size_t getMethods() const { return mMethods; }
+    size_t getTemplates() const { return mTemplates; }
+    size_t getTypedefs() const { return mTypedefs; }
+    size_t getEnums() const { return mEnums; }
+    size_t getNamespaceDepth() const { return mNamespaceDepth; }
+    size_t getOperators() const { return mOperators; }
+    size_t getFunctions() const { return mFunctions; }
+    
+    //! returns the code of a header, the index keeps its names unique in the corpus
+    std::string generateHeader( size_t index ) const;
+    //! returns the header included by every header of the corpus
+    std::string generateCommonHeader() const;
+    //! writes count headers and their common header in the directory and returns the paths of the headers
+    std::vector<std::string> write( const std::string &directory, size_t count, const std::string &prefix = "Header" ) const;
+
+protected:
+    size_t  mClasses;
+    size_t  mMethods;
+    size_t  mTemplates;
+    size_t  mTypedefs;
+    size_t  mEnums;
+    size_t  mNamespaceDepth;
+    size_t  mOperators;
+    size_t  mFunctions;
+};
@@ -0,0 +1,246 @@
+//! Runs the Parser end to end on synthetic corpora of several sizes and worker counts and prints the
+//! headers per second, the peak resident memory and the speedup of every worker count. Built from
+//! Sources/Parser.cpp, CorpusGenerator.cpp and this file against the same clang and boost libraries
+//! as the generator, the corpora don't need any system include path.
+//!
+//! usage: ParserBenchmark [--sizes 16,64,256] [--workers 0,1,2,4] [--directory path] [--skip-pathological] [-- compiler flags]
+//!
+//! --emit path writes a corpus of the first size in path/cinder and its bindings with their registration
+//! units in path/bindings, for RegistrationBenchmark to be built from.
+
+#include "Parser.h"
+#include "CorpusGenerator.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+namespace {
+    
+    //! what a run of the Parser measured, the peak memory is the one of the biggest process of the run
+    struct Result {
+        Result() : mHeaders( 0 ), mFailed( 0 ), mParseTime( 0 ), mEmitTime( 0 ), mPeakRss( 0 ), mCrashed( false ) {}
+        
+        double getHeadersPerSecond() const { return mParseTime + mEmitTime > 0 ? mHeaders / ( mParseTime + mEmitTime ) : 0; }
+        
+        size_t  mHeaders;
+        size_t  mFailed;
+        double  mParseTime;
+        double  mEmitTime;
+        size_t  mPeakRss;
+        bool    mCrashed;
+    };
+    
+    vector<size_t> parseList( const string &list )
+    {
+        vector<string> items;
+        boost::split( items, list, boost::is_any_of( "," ) );
+        vector<size_t> values;
+        for( auto item : items ){
+            if( !item.empty() ){
+                values.push_back( stoul( item ) );
+            }
+        }
+        return values;
+    }
+    
+    //! runs the Parser on the headers in a forked process so every run starts from a clean heap and reports its own peak memory
+    Result runParser( const vector<string> &headers, const string &inputDirectory, const string &outputDirectory, size_t workers, const vector<string> &compilerFlags )
+    {
+        fs::remove_all( outputDirectory );
+        fs::create_directories( outputDirectory );
+        
+        int results[2];
+        if( pipe( results ) != 0 ){
+            return Result();
+        }
+        
+        pid_t pid = fork();
+        if( pid == 0 ){
+            close( results[0] );
+            
+            // the generated registry is printed, keep the benchmark output readable
+            int null = open( "/dev/null", O_WRONLY );
+            dup2( null, STDOUT_FILENO );
+            
+            Parser::Options options;
+            options.compilerFlags( compilerFlags )
+                .inputDirectory( inputDirectory )
+                .outputDirectory( outputDirectory )
+                .workers( workers )
+                .workerTimeout( 300 );
+            
+            Parser parser( options );
+            Parser::MemorySink sink;
+            
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            Parser::Model model = parser.parse( headers );
+            double parseTime = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+            
+            start = chrono::steady_clock::now();
+            parser.emit( model, sink );
+            double emitTime = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+            
+            string line = to_string( model.mRecords.size() ) + "\t" + to_string( model.mFailedHeaders.size() ) + "\t" + to_string( parseTime ) + "\t" + to_string( emitTime ) + "\n";
+            ssize_t written = ::write( results[1], line.c_str(), line.size() );
+            _exit( written == static_cast<ssize_t>( line.size() ) ? 0 : 1 );
+        }
+        close( results[1] );
+        
+        string line;
+        char buffer[256];
+        ssize_t count;
+        while( ( count = read( results[0], buffer, sizeof( buffer ) ) ) > 0 ){
+            line.append( buffer, count );
+        }
+        close( results[0] );
+        
+        Result result;
+        int status = 0;
+        struct rusage usage;
+        if( pid < 0 || wait4( pid, &status, 0, &usage ) != pid || !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ){
+            result.mCrashed = true;
+            return result;
+        }
+        
+        stringstream fields( line );
+        fields >> result.mHeaders >> result.mFailed >> result.mParseTime >> result.mEmitTime;
+#if defined( __APPLE__ )
+        result.mPeakRss = usage.ru_maxrss;
+#else
+        result.mPeakRss = usage.ru_maxrss * 1024;
+#endif
+        return result;
+    }
+    
+    void printHeader()
+    {
+        cout << left << setw( 28 ) << "corpus" << right << setw( 8 ) << "headers" << setw( 9 ) << "workers" << setw( 10 ) << "parse s" << setw( 10 ) << "emit s" << setw( 12 ) << "headers/s" << setw( 10 ) << "speedup" << setw( 10 ) << "peak MB" << endl;
+    }
+    
+    void printResult( const string &corpus, size_t workers, const Result &result, double baseline )
+    {
+        cout << left << setw( 28 ) << corpus << right;
+        if( result.mCrashed ){
+            cout << setw( 8 ) << "-" << setw( 9 ) << workers << "  crashed" << endl;
+            return;
+        }
+        cout << setw( 8 ) << result.mHeaders << setw( 9 ) << workers << setw( 10 ) << result.mParseTime << setw( 10 ) << result.mEmitTime;
+        cout << setw( 12 ) << result.getHeadersPerSecond() << setw( 10 ) << ( baseline > 0 ? result.getHeadersPerSecond() / baseline : 0 );
+        cout << setw( 10 ) << result.mPeakRss / ( 1024.0 * 1024.0 );
+        if( result.mFailed ){
+            cout << "  " << result.mFailed << " failed";
+        }
+        cout << endl;
+    }
+    
+    //! runs a corpus with every worker count, the speedup is relative to the first worker count
+    void runCorpus( const string &name, const CorpusGenerator &generator, size_t size, const vector<size_t> &workerCounts, const string &directory, const vector<string> &compilerFlags )
+    {
+        string inputDirectory   = ( fs::path( directory ) / name / "input" ).string();
+        string outputDirectory  = ( fs::path( directory ) / name / "output" ).string();
+        fs::remove_all( inputDirectory );
+        vector<string> headers  = generator.write( inputDirectory, size );
+        
+        double baseline = 0;
+        for( auto workers : workerCounts ){
+            Result result = runParser( headers, inputDirectory, outputDirectory, workers, compilerFlags );
+            if( baseline == 0 ){
+                baseline = result.getHeadersPerSecond();
+            }
+            printResult( name, workers, result, baseline );
+        }
+    }
+
+}
+
+int main( int argc, const char * argv[] )
+{
+    vector<size_t> sizes        = { 16, 64, 256 };
+    vector<size_t> workerCounts = { 0, 1, 2, 4 };
+    string directory            = ( fs::temp_directory_path() / "ParserBenchmark" ).string();
+    bool pathological           = true;
+    string emitDirectory;
+    
+    // the corpora only include each other, a system header search path is never needed
+    vector<string> compilerFlags = { "-x", "c++", "-std=c++11", "-w" };
+    
+    for( int i = 1; i < argc; i++ ){
+        string argument = argv[i];
+        if( argument == "--sizes" && i + 1 < argc ){
+            sizes = parseList( argv[++i] );
+        }
+        else if( argument == "--workers" && i + 1 < argc ){
+            workerCounts = parseList( argv[++i] );
+        }
+        else if( argument == "--directory" && i + 1 < argc ){
+            directory = argv[++i];
+        }
+        else if( argument == "--skip-pathological" ){
+            pathological = false;
+        }
+        else if( argument == "--emit" && i + 1 < argc ){
+            emitDirectory = argv[++i];
+        }
+        else if( argument == "--" ){
+            compilerFlags.insert( compilerFlags.end(), argv + i + 1, argv + argc );
+            break;
+        }
+        else {
+            cerr << "usage: ParserBenchmark [--sizes 16,64,256] [--workers 0,1,2,4] [--directory path] [--skip-pathological] [--emit path] [-- compiler flags]" << endl;
+            return 1;
+        }
+    }
+    
+    // the generated sources include the corpus headers as cinder/ headers
+    if( !emitDirectory.empty() ){
+        string inputDirectory   = ( fs::path( emitDirectory ) / "cinder" ).string();
+        string outputDirectory  = ( fs::path( emitDirectory ) / "bindings" ).string();
+        fs::remove_all( inputDirectory );
+        fs::remove_all( outputDirectory );
+        fs::create_directories( outputDirectory );
+        
+        Parser::Options options;
+        options.compilerFlags( compilerFlags )
+            .inputDirectory( inputDirectory )
+            .outputDirectory( outputDirectory )
+            .inputFileList( CorpusGenerator().write( inputDirectory, sizes.empty() ? 16 : sizes.front() ) )
+            .registrationUnits();
+        Parser( options ).run();
+        return 0;
+    }
+    
+    cout << fixed << setprecision( 2 );
+    cout << "workers 0 parses in process, " << thread::hardware_concurrency() << " hardware threads" << endl << endl;
+    printHeader();
+    
+    // the scaling curves, the same headers with more and more of them
+    for( auto size : sizes ){
+        runCorpus( "default x" + to_string( size ), CorpusGenerator(), size, workerCounts, directory, compilerFlags );
+    }
+    
+    // the cases expected to grow faster than the declarations they contain
+    if( pathological ){
+        vector<size_t> inProcess = { 0 };
+        runCorpus( "400 template typedefs", CorpusGenerator().classes( 8 ).methods( 4 ).templates( 8 ).typedefs( 400 ), 4, inProcess, directory, compilerFlags );
+        runCorpus( "10k methods class", CorpusGenerator().classes( 1 ).methods( 10000 ).operators( 20 ), 1, inProcess, directory, compilerFlags );
+        runCorpus( "deep namespaces", CorpusGenerator().namespaceDepth( 32 ), 16, inProcess, directory, compilerFlags );
+        runCorpus( "80 operators", CorpusGenerator().classes( 2 ).operators( 80 ), 4, inProcess, directory, compilerFlags );
+    }
+    
+    return 0;
+}
@@ -0,0 +1,167 @@
+//! Registers the bindings written by ParserBenchmark --emit in the engine stand-in of MockScriptEngine.h
+//! and prints the registration calls, the time and the allocations of every header. Built from this file
+//! and the generated sources, with the stand-in force included in place of the real engine:
+//!
+//!     ParserBenchmark --emit path
+//!     c++ -std=c++11 -O2 -DNDEBUG -include MockScriptEngine.h -IRuntime -IBenchmarks -Ipath -Ipath/bindings
+//!         Benchmarks/RegistrationBenchmark.cpp path/bindings/*.cpp -o RegistrationBenchmark
+//!
+//! The RegistrationBenchmark target of Benchmarks/CMakeLists.txt runs both steps.
+//!
+//! NDEBUG keeps the asserts of the bindings from stopping at the first refused call, the refused calls
+//! are listed and make the benchmark fail.
+//!
+//! usage: RegistrationBenchmark [--rounds 20]
+
+#include "MockScriptEngine.h"
+#include "CinderRegistrationUnits.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+//! counts the allocations of the bindings, the engine pauses the counting during its own bookkeeping
+void* operator new( size_t size )
+{
+    as::mock::countAllocation( size );
+    if( void* memory = malloc( size ? size : 1 ) ){
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+void operator delete( void* memory ) noexcept
+{
+    free( memory );
+}
+
+namespace {
+    
+    //! what the registration of a unit cost over every round
+    struct UnitResult {
+        UnitResult() : mCalls( 0 ), mNanoseconds( 0 ), mEngineNanoseconds( 0 ), mAllocations( 0 ), mBytes( 0 ) {}
+        
+        size_t      mCalls;
+        uint64_t    mNanoseconds;
+        uint64_t    mEngineNanoseconds;
+        size_t      mAllocations;
+        size_t      mBytes;
+    };
+    
+    //! calls a registration function of a unit and adds what it cost to its result
+    void measure( asIScriptEngine &engine, void (*function)( asIScriptEngine* ), UnitResult *result )
+    {
+        if( !function ){
+            return;
+        }
+        
+        const as::mock::AllocationStats &allocations = as::mock::getAllocationStats();
+        size_t allocationsBefore    = allocations.mAllocations;
+        size_t bytesBefore          = allocations.mBytes;
+        size_t callsBefore          = engine.getCalls();
+        uint64_t engineBefore       = engine.getNanoseconds();
+        
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        function( &engine );
+        result->mNanoseconds        += chrono::duration_cast<chrono::nanoseconds>( chrono::steady_clock::now() - start ).count();
+        
+        result->mCalls              += engine.getCalls() - callsBefore;
+        result->mEngineNanoseconds  += engine.getNanoseconds() - engineBefore;
+        result->mAllocations        += allocations.mAllocations - allocationsBefore;
+        result->mBytes              += allocations.mBytes - bytesBefore;
+    }
+
+}
+
+int main( int argc, const char * argv[] )
+{
+    size_t rounds = 20;
+    for( int i = 1; i < argc; i++ ){
+        string argument = argv[i];
+        if( argument == "--rounds" && i + 1 < argc ){
+            rounds = std::max<size_t>( 1, stoul( argv[++i] ) );
+        }
+        else {
+            cerr << "usage: RegistrationBenchmark [--rounds 20]" << endl;
+            return 1;
+        }
+    }
+    
+    size_t count;
+    const as::RegistrationUnit* units = as::getCinderRegistrationUnits( &count );
+    
+    // every round registers the units in a new engine, declarations first like registerRegistrationUnits
+    vector<UnitResult> results( count );
+    vector<asIScriptEngine::CallStats> calls( asIScriptEngine::NumCalls );
+    vector<string> errors;
+    for( size_t round = 0; round < rounds; round++ ){
+        asIScriptEngine engine;
+        for( size_t i = 0; i < count; i++ ){
+            measure( engine, units[i].mDeclarations, &results[i] );
+        }
+        for( size_t i = 0; i < count; i++ ){
+            measure( engine, units[i].mDefinitions, &results[i] );
+        }
+        
+        for( int call = 0; call < asIScriptEngine::NumCalls; call++ ){
+            const asIScriptEngine::CallStats &stats = engine.getStats( static_cast<asIScriptEngine::Call>( call ) );
+            calls[call].mCalls          += stats.mCalls;
+            calls[call].mFailures       += stats.mFailures;
+            calls[call].mNanoseconds    += stats.mNanoseconds;
+        }
+        if( round == 0 ){
+            errors = engine.getErrors();
+        }
+    }
+    
+    // the most expensive headers first, the bindings time leaves out the time spent in the engine
+    vector<size_t> order( count );
+    for( size_t i = 0; i < count; i++ ){
+        order[i] = i;
+    }
+    sort( order.begin(), order.end(), [&]( size_t a, size_t b ){ return results[a].mNanoseconds > results[b].mNanoseconds; } );
+    
+    double perRound = 1.0 / rounds;
+    cout << fixed << setprecision( 2 );
+    cout << left << setw( 32 ) << "header" << right << setw( 8 ) << "calls" << setw( 12 ) << "total us" << setw( 12 ) << "bindings us" << setw( 12 ) << "engine us" << setw( 10 ) << "allocs" << setw( 10 ) << "KB" << endl;
+    UnitResult total;
+    for( auto i : order ){
+        const UnitResult &result = results[i];
+        cout << left << setw( 32 ) << units[i].mHeader << right << setw( 8 ) << result.mCalls / rounds;
+        cout << setw( 12 ) << result.mNanoseconds * perRound / 1000.0 << setw( 12 ) << ( result.mNanoseconds - result.mEngineNanoseconds ) * perRound / 1000.0 << setw( 12 ) << result.mEngineNanoseconds * perRound / 1000.0;
+        cout << setw( 10 ) << result.mAllocations / rounds << setw( 10 ) << result.mBytes * perRound / 1024.0 << endl;
+        
+        total.mCalls                += result.mCalls;
+        total.mNanoseconds          += result.mNanoseconds;
+        total.mEngineNanoseconds    += result.mEngineNanoseconds;
+        total.mAllocations          += result.mAllocations;
+        total.mBytes                += result.mBytes;
+    }
+    cout << left << setw( 32 ) << "total" << right << setw( 8 ) << total.mCalls / rounds;
+    cout << setw( 12 ) << total.mNanoseconds * perRound / 1000.0 << setw( 12 ) << ( total.mNanoseconds - total.mEngineNanoseconds ) * perRound / 1000.0 << setw( 12 ) << total.mEngineNanoseconds * perRound / 1000.0;
+    cout << setw( 10 ) << total.mAllocations / rounds << setw( 10 ) << total.mBytes * perRound / 1024.0 << endl << endl;
+    
+    cout << left << setw( 32 ) << "call" << right << setw( 8 ) << "calls" << setw( 10 ) << "refused" << setw( 12 ) << "engine ns" << endl;
+    for( int call = 0; call < asIScriptEngine::NumCalls; call++ ){
+        const asIScriptEngine::CallStats &stats = calls[call];
+        if( stats.mCalls ){
+            cout << left << setw( 32 ) << asIScriptEngine::getCallName( static_cast<asIScriptEngine::Call>( call ) ) << right << setw( 8 ) << stats.mCalls / rounds;
+            cout << setw( 10 ) << stats.mFailures / rounds << setw( 12 ) << static_cast<double>( stats.mNanoseconds ) / stats.mCalls << endl;
+        }
+    }
+    
+    // the calls the real engine would refuse, listed once
+    if( !errors.empty() ){
+        cout << endl << errors.size() << " refused calls" << endl;
+        for( size_t i = 0; i < std::min<size_t>( errors.size(), 20 ); i++ ){
+            cout << "    " << errors[i] << endl;
+        }
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// The generated sources include the registration helpers of the host application. The corpus
+// bindings don't use any of them, this empty header lets them build against MockScriptEngine.h.
@@ -0,0 +1,203 @@
+//! Times the Visitor string helpers on a fixture AST built once, and prints their nanoseconds and
+//! allocations per call. Built from Sources/Parser.cpp and this file against the same clang and
+//! boost libraries as the generator with CLANG_PARSER_BENCHMARKS defined, the fixture doesn't need
+//! any system include path.
+//!
+//! usage: VisitorBenchmark [--iterations 10000] [-- compiler flags]
+
+#include "Parser.h"
+
+#include "clang/Frontend/ASTUnit.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+namespace {
+    
+    //! counted by the replaced global operator new, the benchmark is single threaded
+    size_t sAllocations     = 0;
+    size_t sAllocatedBytes  = 0;
+    
+    //! the declarations the helpers meet in the Cinder headers: nested scopes, aliases, template
+    //! typedefs, default arguments, const references and the pointers the generator doesn't support
+    const char* sFixture =
+        "namespace geom {\n"
+        "    namespace detail { class Storage {}; }\n"
+        "    class Vec3 { public: float x, y, z; };\n"
+        "    template<typename T> class Box { public: T mMin, mMax; };\n"
+        "    typedef Box<float> Boxf;\n"
+        "    class TriMesh {\n"
+        "    public:\n"
+        "        void setPositions( const Vec3 &position, float scale = 1.0f, int count = 0 );\n"
+        "        const Vec3& getCenter() const;\n"
+        "        Boxf getBounds( const Boxf &bounds, bool expand = true ) const;\n"
+        "        void setStorage( detail::Storage *storage );\n"
+        "        static TriMesh create( const Vec3 &size, unsigned int subdivisions = 4 );\n"
+        "        TriMesh& operator+=( const TriMesh &other );\n"
+        "    };\n"
+        "    float distance( const Vec3 &a, const Vec3 &b );\n"
+        "}\n"
+        "namespace gd = geom::detail;\n"
+        "void draw( const geom::TriMesh &mesh, const gd::Storage &storage, double time );\n";
+    
+    //! collects the functions and namespace aliases of the fixture
+    class Collector : public clang::RecursiveASTVisitor<Collector> {
+    public:
+        explicit Collector( clang::ASTContext* context ) : mContext( context ) {}
+        
+        bool VisitFunctionDecl( clang::FunctionDecl *function )
+        {
+            if( mContext->getSourceManager().isInMainFile( function->getLocation() ) ){
+                mFunctions.push_back( function );
+            }
+            return true;
+        }
+        bool VisitNamespaceAliasDecl( clang::NamespaceAliasDecl *alias )
+        {
+            mAliases.push_back( alias );
+            return true;
+        }
+        
+        clang::ASTContext*                      mContext;
+        std::vector<clang::FunctionDecl*>       mFunctions;
+        std::vector<clang::NamespaceAliasDecl*> mAliases;
+    };
+    
+    //! the unsupported types of the Cinder bindings
+    Parser::Options getCinderOptions()
+    {
+        Parser::Options options;
+        options.unsupportedTypes( { "*", "~", "Ref", "std::vector", "unspecified_bool_type", "std::pair", "boost::container", "NodeType", "std::ostream", "type-parameter", "typename", "DIST", "Vec3f" } );
+        return options;
+    }
+
+}
+
+//! counts the allocations of the helpers, the array forms forward to it
+void* operator new( size_t size )
+{
+    sAllocations++;
+    sAllocatedBytes += size;
+    if( void* memory = malloc( size ? size : 1 ) ){
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+void operator delete( void* memory ) noexcept
+{
+    free( memory );
+}
+
+//! owns the Visitor helpers on the fixture AST and times them over the fixture declarations
+class VisitorBenchmark {
+public:
+    VisitorBenchmark( clang::ASTContext* context, const Collector &collector )
+    : mVisitor( context, getCinderOptions() ), mSink( 0 )
+    {
+        for( auto alias : collector.mAliases ){
+            mVisitor.addNamespaceAlias( alias );
+        }
+        mFunctions = collector.mFunctions;
+        for( auto function : mFunctions ){
+            mTypes.push_back( function->getResultType() );
+            for( unsigned i = 0; i < function->getNumParams(); i++ ){
+                mTypes.push_back( function->getParamDecl( i )->getType() );
+            }
+        }
+        
+        // the strings the helpers are given while the classes and functions are emitted
+        for( auto type : mTypes ){
+            mNames.push_back( mVisitor.getTypeQualifiedName( type ) );
+        }
+        for( auto function : mFunctions ){
+            mNames.push_back( mVisitor.getDeclarationQualifiedName( function ) );
+        }
+    }
+    
+    void run( size_t iterations )
+    {
+        cout << left << setw( 30 ) << "helper" << right << setw( 8 ) << "inputs" << setw( 12 ) << "ns/op" << setw( 12 ) << "allocs/op" << setw( 12 ) << "bytes/op" << endl;
+        
+        measure( "getTypeName", mTypes, iterations, [this]( const clang::QualType &type ){ return mVisitor.getTypeName( type ); } );
+        measure( "getTypeQualifiedName", mTypes, iterations, [this]( const clang::QualType &type ){ return mVisitor.getTypeQualifiedName( type ); } );
+        measure( "getFunctionArgList", mFunctions, iterations, [this]( clang::FunctionDecl *function ){ return mVisitor.getFunctionArgList( function ); } );
+        measure( "styleScopedName", mNames, iterations, [this]( const string &name ){ return mVisitor.styleScopedName( name ); } );
+        measure( "replaceNamespacesByAliases", mNames, iterations, [this]( const string &name ){ return mVisitor.replaceNamespacesByAliases( name ); } );
+        measure( "isSupported", mNames, iterations, [this]( const string &name ){ return mVisitor.isSupported( name ) ? name : string(); } );
+        
+        // keeps the results alive so the calls can't be optimized away
+        cout << endl << "checksum " << mSink << endl;
+    }
+
+protected:
+    //! calls a helper on every input, a first pass warms up the caches before the measured ones
+    template<typename Input, typename Helper>
+    void measure( const string &name, const vector<Input> &inputs, size_t iterations, Helper helper )
+    {
+        for( const auto &input : inputs ){
+            mSink += helper( input ).size();
+        }
+        
+        size_t allocations  = sAllocations;
+        size_t bytes        = sAllocatedBytes;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for( size_t i = 0; i < iterations; i++ ){
+            for( const auto &input : inputs ){
+                mSink += helper( input ).size();
+            }
+        }
+        double nanoseconds  = chrono::duration<double,nano>( chrono::steady_clock::now() - start ).count();
+        double calls        = static_cast<double>( iterations * inputs.size() );
+        
+        cout << left << setw( 30 ) << name << right << setw( 8 ) << inputs.size() << fixed << setprecision( 1 );
+        cout << setw( 12 ) << nanoseconds / calls << setw( 12 ) << ( sAllocations - allocations ) / calls << setw( 12 ) << ( sAllocatedBytes - bytes ) / calls << endl;
+    }
+    
+    Parser::VisitorHelpers              mVisitor;
+    
+    std::vector<clang::FunctionDecl*>   mFunctions;
+    std::vector<clang::QualType>        mTypes;
+    std::vector<std::string>            mNames;
+    size_t                              mSink;
+};
+
+int main( int argc, const char * argv[] )
+{
+    size_t iterations           = 10000;
+    vector<string> arguments    = { "-x", "c++", "-std=c++11", "-w" };
+    
+    for( int i = 1; i < argc; i++ ){
+        string argument = argv[i];
+        if( argument == "--iterations" && i + 1 < argc ){
+            iterations = stoul( argv[++i] );
+        }
+        else if( argument == "--" ){
+            arguments.insert( arguments.end(), argv + i + 1, argv + argc );
+            break;
+        }
+        else {
+            cerr << "usage: VisitorBenchmark [--iterations 10000] [-- compiler flags]" << endl;
+            return 1;
+        }
+    }
+    
+    // the fixture is parsed once, every helper reads the same declarations
+    std::unique_ptr<clang::ASTUnit> unit( clang::tooling::buildASTFromCodeWithArgs( sFixture, arguments, "Fixture.h" ) );
+    if( !unit ){
+        cerr << "Failed to parse the fixture" << endl;
+        return 1;
+    }
+    clang::ASTContext &context = unit->getASTContext();
+    Collector collector( &context );
+    collector.TraverseDecl( context.getTranslationUnitDecl() );
+    
+    VisitorBenchmark benchmark( &context, collector );
+    benchmark.run( iterations );
+    
+    return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace as {
+    
+    //! call count of each binding indexed by binding id, defined by the generated CinderBindingCounters.cpp
+    extern std::atomic<uint64_t> sBindingCallCounts[];
+    
+    //! Registered instead of a method, counts the call and forwards it to the method.
+    //! The signature is explicit so overloaded methods resolve to the bound one.
+    template<size_t Id, typename Signature, Signature Method>
+    struct CountedMethod;
+    
+    template<size_t Id, typename C, typename R, typename... Args, R (C::*Method)( Args... )>
+    struct CountedMethod<Id, R (C::*)( Args... ), Method> {
+        static R call( C *object, Args... args )
+        {
+            sBindingCallCounts[Id].fetch_add( 1, std::memory_order_relaxed );
+            return ( object->*Method )( std::forward<Args>( args )... );
+        }
+    };
+    
+    template<size_t Id, typename C, typename R, typename... Args, R (C::*Method)( Args... ) const>
+    struct CountedMethod<Id, R (C::*)( Args... ) const, Method> {
+        static R call( const C *object, Args... args )
+        {
+            sBindingCallCounts[Id].fetch_add( 1, std::memory_order_relaxed );
+            return ( object->*Method )( std::forward<Args>( args )... );
+        }
+    };
+    
+    //! Registered instead of a global or static function, counts the call and forwards it to the function
+    template<size_t Id, typename Signature, Signature Function>
+    struct CountedFunction;
+    
+    template<size_t Id, typename R, typename... Args, R (*Function)( Args... )>
+    struct CountedFunction<Id, R (*)( Args... ), Function> {
+        static R call( Args... args )
+        {
+            sBindingCallCounts[Id].fetch_add( 1, std::memory_order_relaxed );
+            return Function( std::forward<Args>( args )... );
+        }
+    };
+    
+    //! returns the called bindings and their count, most called first
+    inline std::vector<std::pair<std::string,uint64_t>> getBindingCallCounts( const char* const* names, size_t count )
+    {
+        std::vector<std::pair<std::string,uint64_t>> counts;
+        for( size_t i = 0; i < count; i++ ){
+            uint64_t calls = sBindingCallCounts[i].load( std::memory_order_relaxed );
+            if( calls ){
+                counts.push_back( std::make_pair( std::string( names[i] ), calls ) );
+            }
+        }
+        std::stable_sort( counts.begin(), counts.end(), []( const std::pair<std::string,uint64_t> &a, const std::pair<std::string,uint64_t> &b ){ return a.second > b.second; } );
+        return counts;
+    }
+    
+    //! writes the called bindings and their count, most called first
+    inline void dumpBindingCallCounts( std::ostream &stream, const char* const* names, size_t count )
+    {
+        for( const auto &binding : getBindingCallCounts( names, count ) ){
+            stream << binding.second << "\t" << binding.first << std::endl;
+        }
+    }
+    
+    //! sets every count back to zero
+    inline void resetBindingCallCounts( size_t count )
+    {
+        for( size_t i = 0; i < count; i++ ){
+            sBindingCallCounts[i].store( 0, std::memory_order_relaxed );
+        }
+    }
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// Avoid having to inform include path if header is already include before
+#ifndef ANGELSCRIPT_H
+    #include <angelscript.h>
+#endif
+
+namespace as {
+    
+    //! describes a single registration call of a binding table. Strings are stored as indices
+    //! in the translation unit string table so each declaration is only stored once.
+    struct BindingEntry {
+        enum Kind : uint8_t { ObjectMethod, ObjectBehaviour, GlobalFunction };
+        
+        uint8_t     mKind;
+        uint8_t     mCallConv;
+        uint16_t    mBehaviour;
+        uint32_t    mNamespace;
+        uint32_t    mObject;
+        uint32_t    mDeclaration;
+    };
+    
+    //! registers a binding table. Entries are expected to be grouped by namespace,
+    //! the default namespace is only changed when two consecutive entries differ.
+    inline void registerBindingTable( asIScriptEngine* engine, const char* const* strings, const BindingEntry* entries, const asSFuncPtr* functions, size_t count )
+    {
+        int r = 0;
+        uint32_t currentNamespace = ~0u;
+        
+        for( size_t i = 0; i < count; i++ ){
+            const BindingEntry &entry = entries[i];
+            
+            if( entry.mNamespace != currentNamespace ){
+                r = engine->SetDefaultNamespace( strings[entry.mNamespace] ); assert( r >= 0 );
+                currentNamespace = entry.mNamespace;
+            }
+            
+            switch( entry.mKind ){
+                case BindingEntry::ObjectMethod:
+                    r = engine->RegisterObjectMethod( strings[entry.mObject], strings[entry.mDeclaration], functions[i], entry.mCallConv );
+                    break;
+                case BindingEntry::ObjectBehaviour:
+                    r = engine->RegisterObjectBehaviour( strings[entry.mObject], static_cast<asEBehaviours>( entry.mBehaviour ), strings[entry.mDeclaration], functions[i], entry.mCallConv );
+                    break;
+                case BindingEntry::GlobalFunction:
+                    r = engine->RegisterGlobalFunction( strings[entry.mDeclaration], functions[i], entry.mCallConv );
+                    break;
+            }
+            assert( r >= 0 );
+        }
+        
+        // set back to empty default namespace
+        if( currentNamespace != 0 ){
+            r = engine->SetDefaultNamespace( "" ); assert( r >= 0 );
+        }
+    }
+
+}
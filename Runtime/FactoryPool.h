@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// the c++0x toolchains of Xcode before 8 have no thread_local, the local lists are then kept in pthread keys
+#if defined( __clang__ ) && defined( __has_feature )
+    #if !__has_feature( cxx_thread_local )
+        #define AS_FACTORY_POOL_PTHREAD_KEYS
+    #endif
+#endif
+
+#if defined( AS_FACTORY_POOL_PTHREAD_KEYS )
+    #include <pthread.h>
+#endif
+
+// the live count, high water mark and allocations cost a few atomic operations on the shared list for
+// every allocation, they are only kept by the debug builds unless AS_FACTORY_POOL_STATS is defined
+#if !defined( AS_FACTORY_POOL_STATS ) && !defined( NDEBUG )
+    #define AS_FACTORY_POOL_STATS
+#endif
+
+namespace as {
+    
+    //! statistics of a size class pool, only the reserved blocks are counted without AS_FACTORY_POOL_STATS
+    struct FactoryPoolStats {
+        size_t  mBlockSize;
+        size_t  mLiveCount;
+        size_t  mHighWaterMark;
+        size_t  mAllocations;
+        size_t  mReservedBlocks;
+    };
+    
+    namespace detail {
+        
+        //! keeps track of every instantiated pool so their statistics can be listed
+        class FactoryPoolRegistry {
+        public:
+            typedef FactoryPoolStats (*StatsFn)();
+            
+            static FactoryPoolRegistry& get() { static FactoryPoolRegistry registry; return registry; }
+            
+            void add( StatsFn stats ) { std::lock_guard<std::mutex> lock( mMutex ); mPools.push_back( stats ); }
+            std::vector<FactoryPoolStats> getStats()
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                std::vector<FactoryPoolStats> stats;
+                for( auto pool : mPools ){
+                    stats.push_back( pool() );
+                }
+                return stats;
+            }
+        
+        private:
+            std::mutex              mMutex;
+            std::vector<StatsFn>    mPools;
+        };
+        
+        //! intrusive singly linked list of free blocks
+        struct FreeBlock {
+            FreeBlock* mNext;
+        };
+        
+        template<size_t BlockSize>
+        FactoryPoolStats getFreeListStats();
+        
+        //! free-list of fixed size blocks shared by every thread
+        template<size_t BlockSize>
+        class SharedFreeList {
+        public:
+            static SharedFreeList& get() { static SharedFreeList list; return list; }
+            
+            //! pops a block, carving a new chunk when the list is empty
+            void* pop()
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                if( mHead == nullptr ){
+                    grow();
+                }
+                FreeBlock* block = mHead;
+                mHead = block->mNext;
+                return block;
+            }
+            //! pushes a chain of blocks back to the list
+            void push( FreeBlock* first, FreeBlock* last )
+            {
+                std::lock_guard<std::mutex> lock( mMutex );
+                last->mNext = mHead;
+                mHead = first;
+            }
+            
+            std::atomic<size_t> mLiveCount;
+            std::atomic<size_t> mHighWaterMark;
+            std::atomic<size_t> mAllocations;
+            std::atomic<size_t> mReservedBlocks;
+            
+            static const size_t sBlocksPerChunk = 64;
+        
+        private:
+            
+            SharedFreeList() : mLiveCount( 0 ), mHighWaterMark( 0 ), mAllocations( 0 ), mReservedBlocks( 0 ), mHead( nullptr )
+            {
+                FactoryPoolRegistry::get().add( &getFreeListStats<BlockSize> );
+            }
+            
+            // chunks are never given back to the system, the blocks are recycled instead
+            void grow()
+            {
+                char* chunk = static_cast<char*>( ::operator new( BlockSize * sBlocksPerChunk ) );
+                for( size_t i = 0; i < sBlocksPerChunk; i++ ){
+                    FreeBlock* block = reinterpret_cast<FreeBlock*>( chunk + i * BlockSize );
+                    block->mNext = mHead;
+                    mHead = block;
+                }
+                mReservedBlocks.fetch_add( sBlocksPerChunk, std::memory_order_relaxed );
+            }
+            
+            std::mutex  mMutex;
+            FreeBlock*  mHead;
+        };
+        
+        //! per thread cache of a shared free-list, given back to the shared list when the thread exits. A thread
+        //! freeing more blocks than it allocates gives half of its cache back once it holds two chunks of blocks.
+        template<size_t BlockSize>
+        class LocalFreeList {
+        public:
+            LocalFreeList() : mHead( nullptr ), mTail( nullptr ), mCount( 0 ) {}
+            ~LocalFreeList()
+            {
+                if( mHead != nullptr ){
+                    SharedFreeList<BlockSize>::get().push( mHead, mTail );
+                }
+            }
+            
+            void* pop()
+            {
+                if( mHead == nullptr ){
+                    return SharedFreeList<BlockSize>::get().pop();
+                }
+                FreeBlock* block = mHead;
+                mHead = block->mNext;
+                if( mHead == nullptr ){
+                    mTail = nullptr;
+                }
+                mCount--;
+                return block;
+            }
+            void push( void* ptr )
+            {
+                FreeBlock* block = static_cast<FreeBlock*>( ptr );
+                block->mNext = mHead;
+                mHead = block;
+                if( mTail == nullptr ){
+                    mTail = block;
+                }
+                if( ++mCount >= sMaxBlocks ){
+                    trim();
+                }
+            }
+        
+        private:
+            static const size_t sMaxBlocks = 2 * SharedFreeList<BlockSize>::sBlocksPerChunk;
+            
+            //! gives the most recently freed half of the cache back to the shared list
+            void trim()
+            {
+                FreeBlock* last = mHead;
+                for( size_t i = 1; i < sMaxBlocks / 2; i++ ){
+                    last = last->mNext;
+                }
+                FreeBlock* first = mHead;
+                mHead = last->mNext;
+                mCount -= sMaxBlocks / 2;
+                SharedFreeList<BlockSize>::get().push( first, last );
+            }
+            
+            FreeBlock*  mHead;
+            FreeBlock*  mTail;
+            size_t      mCount;
+        };
+
+#if defined( AS_FACTORY_POOL_PTHREAD_KEYS )
+        //! the pthread key holding the local list of each thread, the key destructor gives its blocks back
+        template<size_t BlockSize>
+        class LocalFreeListKey {
+        public:
+            static LocalFreeList<BlockSize>& getList()
+            {
+                static LocalFreeListKey key;
+                LocalFreeList<BlockSize>* list = static_cast<LocalFreeList<BlockSize>*>( pthread_getspecific( key.mKey ) );
+                if( list == nullptr ){
+                    list = new LocalFreeList<BlockSize>();
+                    pthread_setspecific( key.mKey, list );
+                }
+                return *list;
+            }
+        
+        private:
+            LocalFreeListKey() { pthread_key_create( &mKey, &destroyList ); }
+            
+            static void destroyList( void* list ) { delete static_cast<LocalFreeList<BlockSize>*>( list ); }
+            
+            pthread_key_t mKey;
+        };
+#endif
+        
+        template<size_t BlockSize>
+        FactoryPoolStats getFreeListStats()
+        {
+            SharedFreeList<BlockSize> &shared = SharedFreeList<BlockSize>::get();
+            FactoryPoolStats stats = {
+                BlockSize,
+                shared.mLiveCount.load( std::memory_order_relaxed ),
+                shared.mHighWaterMark.load( std::memory_order_relaxed ),
+                shared.mAllocations.load( std::memory_order_relaxed ),
+                shared.mReservedBlocks.load( std::memory_order_relaxed )
+            };
+            return stats;
+        }
+        
+        //! rounds a size up to its size class, a multiple of the maximum fundamental alignment. The blocks
+        //! are only aligned that much, the factories refuse the over-aligned types.
+        constexpr size_t getSizeClass( size_t size )
+        {
+            return ( ( size < sizeof( FreeBlock ) ? sizeof( FreeBlock ) : size ) + alignof( std::max_align_t ) - 1 ) / alignof( std::max_align_t ) * alignof( std::max_align_t );
+        }
+        
+    }
+    
+    //! Allocates the generated factories objects from size class free-lists instead of the global
+    //! allocator. With ThreadLocal each thread recycles its own blocks without taking any lock.
+    template<bool ThreadLocal = false>
+    class PoolAllocator {
+    public:
+        template<size_t Size>
+        static void* allocate()
+        {
+            static_assert( detail::getSizeClass( Size ) >= Size, "invalid size class" );
+            typedef detail::SharedFreeList<detail::getSizeClass( Size )> SharedList;
+            
+            SharedList &shared = SharedList::get();
+#if defined( AS_FACTORY_POOL_STATS )
+            size_t live = shared.mLiveCount.fetch_add( 1, std::memory_order_relaxed ) + 1;
+            size_t highWaterMark = shared.mHighWaterMark.load( std::memory_order_relaxed );
+            while( live > highWaterMark && !shared.mHighWaterMark.compare_exchange_weak( highWaterMark, live, std::memory_order_relaxed ) );
+            shared.mAllocations.fetch_add( 1, std::memory_order_relaxed );
+#endif
+            
+            return ThreadLocal ? getLocalList<detail::getSizeClass( Size )>().pop() : shared.pop();
+        }
+        
+        template<size_t Size>
+        static void deallocate( void* ptr )
+        {
+            typedef detail::SharedFreeList<detail::getSizeClass( Size )> SharedList;
+            
+            SharedList &shared = SharedList::get();
+#if defined( AS_FACTORY_POOL_STATS )
+            shared.mLiveCount.fetch_sub( 1, std::memory_order_relaxed );
+#endif
+            
+            if( ThreadLocal ){
+                getLocalList<detail::getSizeClass( Size )>().push( ptr );
+            }
+            else {
+                detail::FreeBlock* block = static_cast<detail::FreeBlock*>( ptr );
+                shared.push( block, block );
+            }
+        }
+    
+    private:
+        template<size_t BlockSize>
+        static detail::LocalFreeList<BlockSize>& getLocalList()
+        {
+#if defined( AS_FACTORY_POOL_PTHREAD_KEYS )
+            return detail::LocalFreeListKey<BlockSize>::getList();
+#else
+            static thread_local detail::LocalFreeList<BlockSize> list;
+            return list;
+#endif
+        }
+    };
+    
+    //! returns the statistics of every size class pool used so far
+    inline std::vector<FactoryPoolStats> getFactoryPoolsStats()
+    {
+        std::vector<FactoryPoolStats> stats = detail::FactoryPoolRegistry::get().getStats();
+        std::sort( stats.begin(), stats.end(), []( const FactoryPoolStats &a, const FactoryPoolStats &b ){ return a.mBlockSize < b.mBlockSize; } );
+        return stats;
+    }
+
+}
@@ -0,0 +1,582 @@
+#pragma once
+
+// Header-only stand-in for the part of the AngelScript registration interface used by the generated
+// bindings and the runtime headers. Force include it before the generated sources, ANGELSCRIPT_H keeps
+// them from including the real engine. Nothing can be executed, the engine only validates, counts
+// and times the registration calls.
+#ifndef ANGELSCRIPT_H
+#define ANGELSCRIPT_H
+
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+typedef unsigned char   asBYTE;
+typedef unsigned int    asUINT;
+typedef unsigned int    asDWORD;
+typedef size_t          asPWORD;
+
+enum asERetCodes {
+    asSUCCESS               = 0,
+    asERROR                 = -1,
+    asINVALID_ARG           = -5,
+    asNO_FUNCTION           = -6,
+    asNOT_SUPPORTED         = -7,
+    asINVALID_NAME          = -8,
+    asNAME_TAKEN            = -9,
+    asINVALID_DECLARATION   = -10,
+    asINVALID_OBJECT        = -11,
+    asINVALID_TYPE          = -12,
+    asALREADY_REGISTERED    = -13
+};
+
+enum asECallConvTypes {
+    asCALL_CDECL            = 0,
+    asCALL_STDCALL          = 1,
+    asCALL_THISCALL_ASGLOBAL = 2,
+    asCALL_THISCALL         = 3,
+    asCALL_CDECL_OBJLAST    = 4,
+    asCALL_CDECL_OBJFIRST   = 5,
+    asCALL_GENERIC          = 6,
+    asCALL_THISCALL_OBJLAST = 7,
+    asCALL_THISCALL_OBJFIRST = 8
+};
+
+enum asEObjTypeFlags {
+    asOBJ_REF                       = ( 1 << 0 ),
+    asOBJ_VALUE                     = ( 1 << 1 ),
+    asOBJ_GC                        = ( 1 << 2 ),
+    asOBJ_POD                       = ( 1 << 3 ),
+    asOBJ_NOHANDLE                  = ( 1 << 4 ),
+    asOBJ_SCOPED                    = ( 1 << 5 ),
+    asOBJ_TEMPLATE                  = ( 1 << 6 ),
+    asOBJ_ASHANDLE                  = ( 1 << 7 ),
+    asOBJ_APP_CLASS                 = ( 1 << 8 ),
+    asOBJ_APP_CLASS_CONSTRUCTOR     = ( 1 << 9 ),
+    asOBJ_APP_CLASS_DESTRUCTOR      = ( 1 << 10 ),
+    asOBJ_APP_CLASS_ASSIGNMENT      = ( 1 << 11 ),
+    asOBJ_APP_CLASS_COPY_CONSTRUCTOR = ( 1 << 12 ),
+    asOBJ_APP_CLASS_C               = ( asOBJ_APP_CLASS + asOBJ_APP_CLASS_CONSTRUCTOR ),
+    asOBJ_APP_CLASS_CD              = ( asOBJ_APP_CLASS + asOBJ_APP_CLASS_CONSTRUCTOR + asOBJ_APP_CLASS_DESTRUCTOR ),
+    asOBJ_APP_CLASS_CDA             = ( asOBJ_APP_CLASS + asOBJ_APP_CLASS_CONSTRUCTOR + asOBJ_APP_CLASS_DESTRUCTOR + asOBJ_APP_CLASS_ASSIGNMENT ),
+    asOBJ_APP_CLASS_CDAK            = ( asOBJ_APP_CLASS + asOBJ_APP_CLASS_CONSTRUCTOR + asOBJ_APP_CLASS_DESTRUCTOR + asOBJ_APP_CLASS_ASSIGNMENT + asOBJ_APP_CLASS_COPY_CONSTRUCTOR ),
+    asOBJ_APP_PRIMITIVE             = ( 1 << 13 ),
+    asOBJ_APP_FLOAT                 = ( 1 << 14 )
+};
+
+enum asEBehaviours {
+    asBEHAVE_CONSTRUCT,
+    asBEHAVE_LIST_CONSTRUCT,
+    asBEHAVE_DESTRUCT,
+    asBEHAVE_FACTORY,
+    asBEHAVE_LIST_FACTORY,
+    asBEHAVE_ADDREF,
+    asBEHAVE_RELEASE,
+    asBEHAVE_GET_WEAKREF_FLAG,
+    asBEHAVE_TEMPLATE_CALLBACK,
+    asBEHAVE_MAX
+};
+
+typedef void (*asFUNCTION_t)();
+
+//! a function or method pointer, kept as bytes like the real engine does
+struct asSFuncPtr {
+    //! 2 for a function, 3 for a method
+    explicit asSFuncPtr( asBYTE flag = 0 ) : mFlag( flag ) { memset( mPointer, 0, sizeof( mPointer ) ); }
+    
+    void copyPointer( const void* pointer, size_t size ) { memcpy( mPointer, pointer, size ); }
+    bool isNull() const
+    {
+        for( size_t i = 0; i < sizeof( mPointer ); i++ ){
+            if( mPointer[i] ) return false;
+        }
+        return true;
+    }
+    
+    char    mPointer[25];
+    asBYTE  mFlag;
+};
+
+template<typename T>
+inline asSFuncPtr asFunctionPtr( T function )
+{
+    asSFuncPtr pointer( 2 );
+    asFUNCTION_t cast = reinterpret_cast<asFUNCTION_t>( function );
+    pointer.copyPointer( &cast, sizeof( cast ) );
+    return pointer;
+}
+
+template<int N>
+struct asSMethodPtr {
+    template<typename M>
+    static asSFuncPtr Convert( M method )
+    {
+        static_assert( N <= 25, "method pointers are limited to 25 bytes" );
+        asSFuncPtr pointer( 3 );
+        pointer.copyPointer( &method, N );
+        return pointer;
+    }
+};
+
+#define asFUNCTION( f ) asFunctionPtr( f )
+#define asFUNCTIONPR( f, p, r ) asFunctionPtr( reinterpret_cast<void (*)()>( static_cast<r (*)p>( f ) ) )
+#define asMETHOD( c, m ) asSMethodPtr<sizeof( void (c::*)() )>::Convert( (void (c::*)())( &c::m ) )
+#define asMETHODPR( c, m, p, r ) asSMethodPtr<sizeof( void (c::*)() )>::Convert( static_cast<r (c::*)p>( &c::m ) )
+#define asOFFSET( s, m ) ( (size_t)( &reinterpret_cast<s*>( 100000 )->m ) - 100000 )
+
+//! returns the application class flags of a value type
+template<typename T>
+asUINT asGetTypeTraits()
+{
+    bool hasConstructor         = std::is_default_constructible<T>::value && !std::is_trivially_default_constructible<T>::value;
+    bool hasDestructor          = std::is_destructible<T>::value && !std::is_trivially_destructible<T>::value;
+    bool hasAssignment          = std::is_copy_assignable<T>::value && !std::is_trivially_copy_assignable<T>::value;
+    bool hasCopyConstructor     = std::is_copy_constructible<T>::value && !std::is_trivially_copy_constructible<T>::value;
+    
+    if( std::is_floating_point<T>::value ) return asOBJ_APP_FLOAT;
+    if( std::is_integral<T>::value || std::is_pointer<T>::value || std::is_enum<T>::value ) return asOBJ_APP_PRIMITIVE;
+    return asOBJ_APP_CLASS | ( hasConstructor ? asOBJ_APP_CLASS_CONSTRUCTOR : 0 ) | ( hasDestructor ? asOBJ_APP_CLASS_DESTRUCTOR : 0 )
+        | ( hasAssignment ? asOBJ_APP_CLASS_ASSIGNMENT : 0 ) | ( hasCopyConstructor ? asOBJ_APP_CLASS_COPY_CONSTRUCTOR : 0 );
+}
+
+//! no script ever runs, the exceptions are only kept
+class asIScriptContext {
+public:
+    int SetException( const char* message ) { mException = message; return asSUCCESS; }
+    
+    std::string mException;
+};
+
+inline asIScriptContext* asGetActiveContext() { return nullptr; }
+
+namespace as {
+    namespace mock {
+        
+        //! the allocations of the bindings, a host replacing the global operator new calls countAllocation
+        struct AllocationStats {
+            size_t  mAllocations;
+            size_t  mBytes;
+            //! the engine own bookkeeping isn't counted
+            int     mPaused;
+        };
+        
+        inline AllocationStats& getAllocationStats()
+        {
+            static AllocationStats stats = { 0, 0, 0 };
+            return stats;
+        }
+        inline void countAllocation( size_t size )
+        {
+            AllocationStats &stats = getAllocationStats();
+            if( !stats.mPaused ){
+                stats.mAllocations++;
+                stats.mBytes += size;
+            }
+        }
+        
+    }
+}
+
+//! Records every registration call. A call is refused with the error code of the real engine when its
+//! object or enum wasn't registered first, when its name is already taken, or when a pointer or a
+//! declaration is missing. The time spent in the engine is kept apart from the time of the bindings.
+class asIScriptEngine {
+public:
+    enum Call { ObjectType, ObjectProperty, ObjectMethod, ObjectBehaviour, GlobalFunction, GlobalProperty, Enum, EnumValue, Typedef, DefaultNamespace, NumCalls };
+    
+    struct CallStats {
+        CallStats() : mCalls( 0 ), mFailures( 0 ), mNanoseconds( 0 ) {}
+        
+        size_t      mCalls;
+        size_t      mFailures;
+        uint64_t    mNanoseconds;
+    };
+    
+    asIScriptEngine() {}
+    
+    int RegisterObjectType( const char* name, int byteSize, asDWORD flags )
+    {
+        Probe probe( this, ObjectType );
+        if( !isValidName( name ) || byteSize < 0 || !( flags & ( asOBJ_REF | asOBJ_VALUE ) ) ){
+            return probe.fail( asINVALID_ARG, "RegisterObjectType", name );
+        }
+        if( !mTypes.insert( getScopedName( name ) ).second ){
+            return probe.fail( asALREADY_REGISTERED, "RegisterObjectType", name );
+        }
+        return asSUCCESS;
+    }
+    int RegisterObjectProperty( const char* object, const char* declaration, int byteOffset )
+    {
+        Probe probe( this, ObjectProperty );
+        if( !isValidDeclaration( declaration, Property ) || byteOffset < 0 ){
+            return probe.fail( asINVALID_DECLARATION, "RegisterObjectProperty", object, declaration );
+        }
+        return addMember( probe, "RegisterObjectProperty", object, declaration );
+    }
+    int RegisterObjectMethod( const char* object, const char* declaration, const asSFuncPtr &function, asDWORD callConv, void* /*auxiliary*/ = nullptr )
+    {
+        Probe probe( this, ObjectMethod );
+        if( function.isNull() || ( callConv != asCALL_THISCALL && callConv != asCALL_CDECL_OBJFIRST && callConv != asCALL_CDECL_OBJLAST && callConv != asCALL_GENERIC ) ){
+            return probe.fail( asNOT_SUPPORTED, "RegisterObjectMethod", object, declaration );
+        }
+        if( !isValidDeclaration( declaration, Function ) ){
+            return probe.fail( asINVALID_DECLARATION, "RegisterObjectMethod", object, declaration );
+        }
+        return addMember( probe, "RegisterObjectMethod", object, declaration );
+    }
+    int RegisterObjectBehaviour( const char* object, asEBehaviours behaviour, const char* declaration, const asSFuncPtr &function, asDWORD /*callConv*/, void* /*auxiliary*/ = nullptr )
+    {
+        Probe probe( this, ObjectBehaviour );
+        if( function.isNull() || behaviour >= asBEHAVE_MAX ){
+            return probe.fail( asINVALID_ARG, "RegisterObjectBehaviour", object, declaration );
+        }
+        if( !isValidDeclaration( declaration, Function ) ){
+            return probe.fail( asINVALID_DECLARATION, "RegisterObjectBehaviour", object, declaration );
+        }
+        // the same behaviour is registered once per signature
+        return addMember( probe, "RegisterObjectBehaviour", object, std::to_string( behaviour ) + " " + declaration );
+    }
+    int RegisterGlobalFunction( const char* declaration, const asSFuncPtr &function, asDWORD /*callConv*/, void* /*auxiliary*/ = nullptr )
+    {
+        Probe probe( this, GlobalFunction );
+        if( function.isNull() ){
+            return probe.fail( asINVALID_ARG, "RegisterGlobalFunction", declaration );
+        }
+        if( !isValidDeclaration( declaration, Function ) ){
+            return probe.fail( asINVALID_DECLARATION, "RegisterGlobalFunction", declaration );
+        }
+        if( !mGlobals.insert( getScopedName( declaration ) ).second ){
+            return probe.fail( asALREADY_REGISTERED, "RegisterGlobalFunction", declaration );
+        }
+        return asSUCCESS;
+    }
+    int RegisterGlobalProperty( const char* declaration, void* pointer )
+    {
+        Probe probe( this, GlobalProperty );
+        if( !pointer || !isValidDeclaration( declaration, Property ) ){
+            return probe.fail( asINVALID_ARG, "RegisterGlobalProperty", declaration );
+        }
+        if( !mGlobals.insert( getScopedName( declaration ) ).second ){
+            return probe.fail( asNAME_TAKEN, "RegisterGlobalProperty", declaration );
+        }
+        return asSUCCESS;
+    }
+    int RegisterEnum( const char* type )
+    {
+        Probe probe( this, Enum );
+        if( !isValidName( type ) ){
+            return probe.fail( asINVALID_NAME, "RegisterEnum", type );
+        }
+        if( !mTypes.insert( getScopedName( type ) ).second ){
+            return probe.fail( asALREADY_REGISTERED, "RegisterEnum", type );
+        }
+        mEnums.insert( getScopedName( type ) );
+        return asSUCCESS;
+    }
+    int RegisterEnumValue( const char* type, const char* name, int /*value*/ )
+    {
+        Probe probe( this, EnumValue );
+        std::string scopedType = findType( type );
+        if( !mEnums.count( scopedType ) ){
+            return probe.fail( asINVALID_TYPE, "RegisterEnumValue", type, name );
+        }
+        if( !isValidName( name ) ){
+            return probe.fail( asINVALID_NAME, "RegisterEnumValue", type, name );
+        }
+        if( !mMembers.insert( scopedType + "|" + name ).second ){
+            return probe.fail( asALREADY_REGISTERED, "RegisterEnumValue", type, name );
+        }
+        return asSUCCESS;
+    }
+    int RegisterTypedef( const char* type, const char* declaration )
+    {
+        Probe probe( this, Typedef );
+        if( !isValidName( type ) || !isValidDeclaration( declaration, Type ) ){
+            return probe.fail( asINVALID_ARG, "RegisterTypedef", type, declaration );
+        }
+        if( !mTypes.insert( getScopedName( type ) ).second ){
+            return probe.fail( asALREADY_REGISTERED, "RegisterTypedef", type );
+        }
+        return asSUCCESS;
+    }
+    int SetDefaultNamespace( const char* nameSpace )
+    {
+        Probe probe( this, DefaultNamespace );
+        if( !nameSpace ){
+            return probe.fail( asINVALID_ARG, "SetDefaultNamespace", "" );
+        }
+        // the namespaces are separated by ::, an empty one is the global namespace
+        std::string name = nameSpace;
+        if( name.find( ":::" ) != std::string::npos || ( !name.empty() && ( name.front() == ':' || name.back() == ':' ) ) ){
+            return probe.fail( asINVALID_ARG, "SetDefaultNamespace", nameSpace );
+        }
+        mNamespace = name;
+        return asSUCCESS;
+    }
+    const char* GetDefaultNamespace() const { return mNamespace.c_str(); }
+    
+    //! returns the number, the failures and the time of a kind of call
+    const CallStats& getStats( Call call ) const { return mStats[call]; }
+    //! returns the name of a kind of call
+    static const char* getCallName( Call call )
+    {
+        static const char* names[NumCalls] = { "RegisterObjectType", "RegisterObjectProperty", "RegisterObjectMethod", "RegisterObjectBehaviour", "RegisterGlobalFunction", "RegisterGlobalProperty", "RegisterEnum", "RegisterEnumValue", "RegisterTypedef", "SetDefaultNamespace" };
+        return names[call];
+    }
+    //! returns the number of calls of every kind
+    size_t getCalls() const
+    {
+        size_t calls = 0;
+        for( int i = 0; i < NumCalls; i++ ) calls += mStats[i].mCalls;
+        return calls;
+    }
+    //! returns the nanoseconds spent in the engine by every kind of call
+    uint64_t getNanoseconds() const
+    {
+        uint64_t nanoseconds = 0;
+        for( int i = 0; i < NumCalls; i++ ) nanoseconds += mStats[i].mNanoseconds;
+        return nanoseconds;
+    }
+    //! returns the refused calls, with their arguments
+    const std::vector<std::string>& getErrors() const { return mErrors; }
+
+private:
+    asIScriptEngine( const asIScriptEngine& );
+    asIScriptEngine& operator=( const asIScriptEngine& );
+    
+    //! counts and times a call, the allocations of the engine are paused meanwhile
+    class Probe {
+    public:
+        Probe( asIScriptEngine* engine, Call call ) : mEngine( engine ), mCall( call ), mStart( std::chrono::steady_clock::now() ) { as::mock::getAllocationStats().mPaused++; }
+        ~Probe()
+        {
+            CallStats &stats = mEngine->mStats[mCall];
+            stats.mCalls++;
+            stats.mNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - mStart ).count();
+            as::mock::getAllocationStats().mPaused--;
+        }
+        
+        int fail( int code, const char* call, const std::string &first, const std::string &second = "" )
+        {
+            mEngine->mStats[mCall].mFailures++;
+            mEngine->mErrors.push_back( std::string( call ) + "( " + first + ( second.empty() ? "" : ", " + second ) + " ) in namespace '" + mEngine->mNamespace + "' returned " + std::to_string( code ) );
+            return code;
+        }
+    
+    private:
+        asIScriptEngine*                        mEngine;
+        Call                                    mCall;
+        std::chrono::steady_clock::time_point   mStart;
+    };
+    
+    static bool isValidName( const char* name )
+    {
+        if( !name || !*name || !( isalpha( static_cast<unsigned char>( *name ) ) || *name == '_' ) ) return false;
+        for( const char* c = name; *c; c++ ){
+            if( !isalnum( static_cast<unsigned char>( *c ) ) && *c != '_' ) return false;
+        }
+        return true;
+    }
+    //! the declarations the registration calls take
+    enum DeclarationKind { Type, Property, Function };
+    
+    //! returns whether a declaration is a type, a type and a name, or a return type, a name, a parameter
+    //! list and an optional const. The types and the parameters are only checked for their structure,
+    //! the types they name don't need to be registered.
+    static bool isValidDeclaration( const char* declaration, DeclarationKind kind )
+    {
+        if( !declaration ){
+            return false;
+        }
+        std::string text = declaration;
+        size_t pos = 0;
+        if( !parseType( text, pos ) ){
+            return false;
+        }
+        if( kind != Type && !parseName( text, pos, false ) ){
+            return false;
+        }
+        if( kind == Function ){
+            skipSpaces( text, pos );
+            if( pos == text.length() || text[pos] != '(' ){
+                return false;
+            }
+            size_t end = findClosingParenthesis( text, pos );
+            if( end == std::string::npos || !isValidParameterList( text.substr( pos + 1, end - pos - 1 ) ) ){
+                return false;
+            }
+            pos = end + 1;
+            skipSpaces( text, pos );
+            parseKeyword( text, pos, "const" );
+        }
+        skipSpaces( text, pos );
+        return pos == text.length();
+    }
+    //! returns whether every comma separated parameter is a type, an optional name and an optional default value
+    static bool isValidParameterList( const std::string &list )
+    {
+        if( list.find_first_not_of( " \t" ) == std::string::npos ){
+            return true;
+        }
+        size_t start = 0;
+        int depth = 0;
+        for( size_t i = 0; i <= list.length(); i++ ){
+            char c = i < list.length() ? list[i] : ',';
+            if( c == '"' || c == '\'' ){
+                i = list.find( c, i + 1 );
+                if( i == std::string::npos ) return false;
+                continue;
+            }
+            if( c == '(' || c == '<' ) depth++;
+            else if( c == ')' || c == '>' ) depth--;
+            else if( c == ',' && depth == 0 ){
+                std::string parameter = list.substr( start, i - start );
+                size_t pos = 0;
+                if( !parseType( parameter, pos ) ){
+                    return false;
+                }
+                parseName( parameter, pos, true );
+                skipSpaces( parameter, pos );
+                // the default value is an expression, it only has to be there
+                if( pos < parameter.length() && ( parameter[pos] != '=' || parameter.find_first_not_of( " \t", pos + 1 ) == std::string::npos ) ){
+                    return false;
+                }
+                start = i + 1;
+            }
+            if( depth < 0 ) return false;
+        }
+        return depth == 0;
+    }
+    //! parses an optionally const and scoped type, its template arguments and its handle, reference and array modifiers
+    static bool parseType( const std::string &text, size_t &pos )
+    {
+        skipSpaces( text, pos );
+        parseKeyword( text, pos, "const" );
+        skipSpaces( text, pos );
+        if( !parseName( text, pos, true ) ){
+            return false;
+        }
+        skipSpaces( text, pos );
+        if( pos < text.length() && text[pos] == '<' ){
+            do {
+                pos++;
+                if( !parseType( text, pos ) ){
+                    return false;
+                }
+                skipSpaces( text, pos );
+            } while( pos < text.length() && text[pos] == ',' );
+            if( pos == text.length() || text[pos] != '>' ){
+                return false;
+            }
+            pos++;
+        }
+        while( true ){
+            skipSpaces( text, pos );
+            if( text.compare( pos, 2, "[]" ) == 0 ){
+                pos += 2;
+            }
+            else if( pos < text.length() && text[pos] == '@' ){
+                pos++;
+                skipSpaces( text, pos );
+                parseKeyword( text, pos, "const" );
+            }
+            else if( pos < text.length() && text[pos] == '&' ){
+                pos++;
+                skipSpaces( text, pos );
+                parseKeyword( text, pos, "inout" ) || parseKeyword( text, pos, "in" ) || parseKeyword( text, pos, "out" );
+            }
+            else {
+                return true;
+            }
+        }
+    }
+    //! parses an identifier, with its namespaces if it can be scoped
+    static bool parseName( const std::string &text, size_t &pos, bool isScoped )
+    {
+        skipSpaces( text, pos );
+        size_t start = pos;
+        while( pos < text.length() ){
+            size_t identifier = pos;
+            if( !isalpha( static_cast<unsigned char>( text[pos] ) ) && text[pos] != '_' ){
+                break;
+            }
+            while( pos < text.length() && ( isalnum( static_cast<unsigned char>( text[pos] ) ) || text[pos] == '_' ) ){
+                pos++;
+            }
+            if( !isScoped || text.compare( pos, 2, "::" ) != 0 ){
+                return true;
+            }
+            pos += 2;
+            if( pos == text.length() || identifier == pos ){
+                break;
+            }
+        }
+        pos = start;
+        return false;
+    }
+    //! parses a keyword that isn't the start of a longer identifier
+    static bool parseKeyword( const std::string &text, size_t &pos, const char* keyword )
+    {
+        size_t length = strlen( keyword );
+        if( text.compare( pos, length, keyword ) != 0 || ( pos + length < text.length() && ( isalnum( static_cast<unsigned char>( text[pos + length] ) ) || text[pos + length] == '_' ) ) ){
+            return false;
+        }
+        pos += length;
+        return true;
+    }
+    static void skipSpaces( const std::string &text, size_t &pos )
+    {
+        while( pos < text.length() && isspace( static_cast<unsigned char>( text[pos] ) ) ) pos++;
+    }
+    //! returns the position of the parenthesis closing the one at a position, or npos
+    static size_t findClosingParenthesis( const std::string &text, size_t pos )
+    {
+        int depth = 0;
+        for( size_t i = pos; i < text.length(); i++ ){
+            if( text[i] == '"' || text[i] == '\'' ){
+                i = text.find( text[i], i + 1 );
+                if( i == std::string::npos ) return std::string::npos;
+            }
+            else if( text[i] == '(' ) depth++;
+            else if( text[i] == ')' && --depth == 0 ) return i;
+        }
+        return std::string::npos;
+    }
+    
+    std::string getScopedName( const std::string &name ) const { return mNamespace.empty() ? name : mNamespace + "::" + name; }
+    //! returns the registered type of that name in the current namespace or the global one
+    std::string findType( const char* name ) const
+    {
+        std::string scoped = getScopedName( name );
+        return mTypes.count( scoped ) ? scoped : name;
+    }
+    //! adds a member to a registered object, once per declaration
+    int addMember( Probe &probe, const char* call, const char* object, const std::string &declaration )
+    {
+        std::string type = object ? findType( object ) : "";
+        if( !mTypes.count( type ) || mEnums.count( type ) ){
+            return probe.fail( asINVALID_OBJECT, call, object ? object : "", declaration );
+        }
+        if( !mMembers.insert( type + "|" + declaration ).second ){
+            return probe.fail( asALREADY_REGISTERED, call, object, declaration );
+        }
+        return asSUCCESS;
+    }
+    
+    std::string                 mNamespace;
+    std::set<std::string>       mTypes;
+    std::set<std::string>       mEnums;
+    std::set<std::string>       mMembers;
+    std::set<std::string>       mGlobals;
+    CallStats                   mStats[NumCalls];
+    std::vector<std::string>    mErrors;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+
+namespace as {
+    
+    //! default allocator of RefCounted, forwards to the global operator new and delete
+    struct HeapAllocator {
+        template<size_t Size>
+        static void* allocate() { return ::operator new( Size ); }
+        template<size_t Size>
+        static void deallocate( void* ptr ) { ::operator delete( ptr ); }
+    };
+    
+    //! Intrusive reference counting for the objects created by the generated factories. The
+    //! counter is allocated in front of the object so AddRef/Release only touch the object own
+    //! memory and engines running on different threads never share any mutable state.
+    template<typename T, typename Allocator = HeapAllocator>
+    class RefCounted {
+        static_assert( alignof(T) <= alignof(std::max_align_t), "the allocators only align the objects to std::max_align_t" );
+    public:
+        //! allocates a default constructed object holding one reference
+        static T* create() { return ( new ( Allocator::template allocate<sizeof(RefCounted)>() ) RefCounted() )->get(); }
+        
+        //! adds a reference to an object returned by create
+        static void addRef( T *ptr ) { fromObject( ptr )->mRefs.fetch_add( 1, std::memory_order_relaxed ); }
+        //! releases a reference and destroys the object with the last one
+        static void release( T *ptr )
+        {
+            RefCounted* block = fromObject( ptr );
+            if( block->mRefs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ){
+                block->~RefCounted();
+                Allocator::template deallocate<sizeof(RefCounted)>( block );
+            }
+        }
+        //! returns the number of references of an object returned by create
+        static uint32_t getRefCount( T *ptr ) { return fromObject( ptr )->mRefs.load( std::memory_order_relaxed ); }
+    
+    private:
+        RefCounted() : mRefs( 1 ) { new ( &mStorage ) T(); }
+        ~RefCounted() { get()->~T(); }
+        
+        T* get() { return reinterpret_cast<T*>( &mStorage ); }
+        static RefCounted* fromObject( T *ptr ) { return reinterpret_cast<RefCounted*>( reinterpret_cast<char*>( ptr ) - offsetof( RefCounted, mStorage ) ); }
+        
+        std::atomic<uint32_t>                                           mRefs;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type      mStorage;
+    };
+    
+    //! Reference counting for the types the scripts can also get from C++, through a returned
+    //! reference or pointer or a property. Those objects don't have room for a counter so the counts
+    //! are kept in tables, only the objects returned by create are destroyed with their last reference.
+    //! The tables are sharded by address, each shard with its own lock, so engines counting different
+    //! objects on different threads almost never wait on each other.
+    template<typename T, typename Allocator = HeapAllocator>
+    class RefCountMap {
+        static_assert( alignof(T) <= alignof(std::max_align_t), "the allocators only align the objects to std::max_align_t" );
+    public:
+        //! allocates a default constructed object holding one reference
+        static T* create()
+        {
+            T* ptr = new ( Allocator::template allocate<sizeof(T)>() ) T();
+            Shard &shard = getShard( ptr );
+            std::lock_guard<std::mutex> lock( shard.mMutex );
+            shard.mCounts[ptr] = Count( 1, true );
+            return ptr;
+        }
+        
+        //! adds a reference to an object, the objects the factory didn't create start counting at their first reference
+        static void addRef( T *ptr )
+        {
+            Shard &shard = getShard( ptr );
+            std::lock_guard<std::mutex> lock( shard.mMutex );
+            shard.mCounts[ptr].mRefs++;
+        }
+        //! releases a reference, the objects returned by create are destroyed with the last one
+        static void release( T *ptr )
+        {
+            bool isOwned = false;
+            {
+                Shard &shard = getShard( ptr );
+                std::lock_guard<std::mutex> lock( shard.mMutex );
+                typename CountTable::iterator it = shard.mCounts.find( ptr );
+                if( it == shard.mCounts.end() || --it->second.mRefs > 0 ){
+                    return;
+                }
+                isOwned = it->second.mIsOwned;
+                shard.mCounts.erase( it );
+            }
+            if( isOwned ){
+                ptr->~T();
+                Allocator::template deallocate<sizeof(T)>( ptr );
+            }
+        }
+        //! returns the number of references of an object, 0 if nothing counts it
+        static uint32_t getRefCount( T *ptr )
+        {
+            Shard &shard = getShard( ptr );
+            std::lock_guard<std::mutex> lock( shard.mMutex );
+            typename CountTable::iterator it = shard.mCounts.find( ptr );
+            return it != shard.mCounts.end() ? it->second.mRefs : 0;
+        }
+    
+    private:
+        struct Count {
+            Count( uint32_t refs = 0, bool isOwned = false ) : mRefs( refs ), mIsOwned( isOwned ) {}
+            
+            uint32_t    mRefs;
+            bool        mIsOwned;
+        };
+        typedef std::unordered_map<T*,Count> CountTable;
+        
+        //! one lock and table per cache line so neighbouring shards don't bounce the same line
+        struct alignas( 64 ) Shard {
+            std::mutex  mMutex;
+            CountTable  mCounts;
+        };
+        static const size_t sShardCount = 64;
+        
+        //! picks the shard of an object, the low bits of an address are the same for every allocation so they are mixed first
+        static Shard& getShard( T *ptr )
+        {
+            static Shard shards[sShardCount];
+            uintptr_t address = reinterpret_cast<uintptr_t>( ptr );
+            return shards[( static_cast<uint64_t>( address >> 4 ) * UINT64_C( 0x9E3779B97F4A7C15 ) >> 32 ) % sShardCount];
+        }
+    };
+
+}
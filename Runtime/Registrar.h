@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cassert>
+
+// Avoid having to inform include path if header is already include before
+#ifndef ANGELSCRIPT_H
+    #include <angelscript.h>
+#endif
+
+namespace as {
+    
+    namespace detail {
+        
+        //! converts a method pointer of any signature to the engine representation, like asMETHOD does
+        template<typename Method>
+        asSFuncPtr getMethodPtr( Method method )
+        {
+            return asSMethodPtr<sizeof( method )>::Convert( method );
+        }
+        
+    }
+    
+    //! Registers the methods and functions of a type, deducing their pointer and calling convention
+    //! from their C++ type so the generated bindings only spell the script declaration.
+    //! Overloads are selected with a static_cast to the bound signature.
+    class Registrar {
+    public:
+        explicit Registrar( asIScriptEngine* engine, const char* object = "" ) : mEngine( engine ), mObject( object ) {}
+        
+        //! registers a method called on the object
+        template<typename C, typename R, typename... Args>
+        Registrar& method( const char* declaration, R (C::*function)( Args... ) )
+        {
+            return method( declaration, detail::getMethodPtr( function ), asCALL_THISCALL );
+        }
+        //! registers a const method called on the object
+        template<typename C, typename R, typename... Args>
+        Registrar& method( const char* declaration, R (C::*function)( Args... ) const )
+        {
+            return method( declaration, detail::getMethodPtr( function ), asCALL_THISCALL );
+        }
+        //! registers a function taking the object as first argument
+        template<typename R, typename... Args>
+        Registrar& method( const char* declaration, R (*function)( Args... ) )
+        {
+            return method( declaration, asFunctionPtr( function ), asCALL_CDECL_OBJFIRST );
+        }
+        //! registers a method with an explicit pointer and calling convention
+        Registrar& method( const char* declaration, const asSFuncPtr &function, asDWORD callConv )
+        {
+            int r = mEngine->RegisterObjectMethod( mObject, declaration, function, callConv ); assert( r >= 0 );
+            return *this;
+        }
+        
+        //! registers a global or static function in the current namespace
+        template<typename R, typename... Args>
+        Registrar& function( const char* declaration, R (*function)( Args... ) )
+        {
+            return this->function( declaration, asFunctionPtr( function ), asCALL_CDECL );
+        }
+        //! registers a global function with an explicit pointer and calling convention
+        Registrar& function( const char* declaration, const asSFuncPtr &function, asDWORD callConv )
+        {
+            int r = mEngine->RegisterGlobalFunction( declaration, function, callConv ); assert( r >= 0 );
+            return *this;
+        }
+    
+    private:
+        asIScriptEngine*    mEngine;
+        const char*         mObject;
+    };
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace as {
+    
+    //! timing of a generated registration function, as reported by getRegistrationProfile
+    struct RegistrationProfileEntry {
+        //! Header entries are the top level declarations and definitions functions, HeaderPart the
+        //! enums and functions they call, and Class the type, fields and methods functions
+        enum Kind : uint8_t { Header, HeaderPart, Class };
+        
+        const char* mHeader;
+        const char* mClass;
+        const char* mFunction;
+        uint8_t     mKind;
+        //! number of registrations done by the function, counted when generating the bindings
+        uint32_t    mEntities;
+        uint32_t    mCalls;
+        uint64_t    mNanoseconds;
+    };
+    
+    //! the entry of a generated profile table, its counters start at zero and are updated atomically
+    //! so engines can be registered on several threads at once
+    struct RegistrationProfileCounter {
+        //! returns the entry reported for the counter
+        RegistrationProfileEntry getEntry() const
+        {
+            RegistrationProfileEntry entry = { mHeader, mClass, mFunction, mKind, mEntities, mCalls.load( std::memory_order_relaxed ), mNanoseconds.load( std::memory_order_relaxed ) };
+            return entry;
+        }
+        
+        const char*             mHeader;
+        const char*             mClass;
+        const char*             mFunction;
+        uint8_t                 mKind;
+        uint32_t                mEntities;
+        std::atomic<uint32_t>   mCalls;
+        std::atomic<uint64_t>   mNanoseconds;
+    };
+    
+    //! times the scope it lives in and adds the result to a profile counter
+    class RegistrationProbe {
+    public:
+        explicit RegistrationProbe( RegistrationProfileCounter &counter ) : mCounter( counter ), mStart( std::chrono::steady_clock::now() ) {}
+        ~RegistrationProbe()
+        {
+            mCounter.mNanoseconds.fetch_add( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - mStart ).count(), std::memory_order_relaxed );
+            mCounter.mCalls.fetch_add( 1, std::memory_order_relaxed );
+        }
+    
+    private:
+        RegistrationProbe( const RegistrationProbe& );
+        RegistrationProbe& operator=( const RegistrationProbe& );
+        
+        RegistrationProfileCounter&             mCounter;
+        std::chrono::steady_clock::time_point   mStart;
+    };
+    
+    namespace detail {
+        
+        //! returns the profile tables of every generated source linked in the application
+        inline std::vector<std::pair<RegistrationProfileCounter*,size_t>>& getRegistrationProfileTables()
+        {
+            static std::vector<std::pair<RegistrationProfileCounter*,size_t>> tables;
+            return tables;
+        }
+        
+    }
+    
+    //! adds the profile table of a generated source during static initialization
+    struct RegistrationProfileRegistrar {
+        RegistrationProfileRegistrar( RegistrationProfileCounter* counters, size_t count ) { detail::getRegistrationProfileTables().push_back( std::make_pair( counters, count ) ); }
+    };
+    
+    //! registration timings per header and per class, sorted from the slowest
+    struct RegistrationProfile {
+        //! the declarations and definitions of each header, mFunction is null
+        std::vector<RegistrationProfileEntry>   mHeaders;
+        //! the type, fields and methods of each class, mFunction is null
+        std::vector<RegistrationProfileEntry>   mClasses;
+        //! every timed function
+        std::vector<RegistrationProfileEntry>   mFunctions;
+        
+        //! returns the total registration time in seconds
+        double getTotalSeconds() const
+        {
+            uint64_t nanoseconds = 0;
+            for( const RegistrationProfileEntry &entry : mHeaders ){
+                nanoseconds += entry.mNanoseconds;
+            }
+            return nanoseconds * 1e-9;
+        }
+    };
+    
+    //! returns the timings gathered by the probes of the generated registration functions
+    inline RegistrationProfile getRegistrationProfile()
+    {
+        RegistrationProfile profile;
+        std::map<std::string,size_t> headers;
+        std::map<std::pair<std::string,std::string>,size_t> classes;
+        
+        for( const auto &table : detail::getRegistrationProfileTables() ){
+            for( size_t i = 0; i < table.second; i++ ){
+                RegistrationProfileEntry entry = table.first[i].getEntry();
+                profile.mFunctions.push_back( entry );
+                
+                // sum the functions of the same header or class, nested header parts are already included
+                if( entry.mKind == RegistrationProfileEntry::Header ){
+                    auto it = headers.insert( std::make_pair( std::string( entry.mHeader ), profile.mHeaders.size() ) );
+                    if( it.second ){
+                        RegistrationProfileEntry header = { entry.mHeader, "", nullptr, RegistrationProfileEntry::Header, 0, 0, 0 };
+                        profile.mHeaders.push_back( header );
+                    }
+                    RegistrationProfileEntry &header = profile.mHeaders[it.first->second];
+                    header.mEntities    += entry.mEntities;
+                    header.mCalls       += entry.mCalls;
+                    header.mNanoseconds += entry.mNanoseconds;
+                }
+                else if( entry.mKind == RegistrationProfileEntry::Class ){
+                    auto it = classes.insert( std::make_pair( std::make_pair( std::string( entry.mHeader ), std::string( entry.mClass ) ), profile.mClasses.size() ) );
+                    if( it.second ){
+                        RegistrationProfileEntry cls = { entry.mHeader, entry.mClass, nullptr, RegistrationProfileEntry::Class, 0, 0, 0 };
+                        profile.mClasses.push_back( cls );
+                    }
+                    RegistrationProfileEntry &cls = profile.mClasses[it.first->second];
+                    cls.mEntities       += entry.mEntities;
+                    cls.mCalls          += entry.mCalls;
+                    cls.mNanoseconds    += entry.mNanoseconds;
+                }
+            }
+        }
+        
+        auto slowest = []( const RegistrationProfileEntry &a, const RegistrationProfileEntry &b ){ return a.mNanoseconds > b.mNanoseconds; };
+        std::stable_sort( profile.mHeaders.begin(), profile.mHeaders.end(), slowest );
+        std::stable_sort( profile.mClasses.begin(), profile.mClasses.end(), slowest );
+        std::stable_sort( profile.mFunctions.begin(), profile.mFunctions.end(), slowest );
+        
+        return profile;
+    }
+    
+    //! resets the timings, for example before registering a new engine
+    inline void resetRegistrationProfile()
+    {
+        for( const auto &table : detail::getRegistrationProfileTables() ){
+            for( size_t i = 0; i < table.second; i++ ){
+                table.first[i].mCalls.store( 0, std::memory_order_relaxed );
+                table.first[i].mNanoseconds.store( 0, std::memory_order_relaxed );
+            }
+        }
+    }
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class asIScriptEngine;
+
+namespace as {
+    
+    //! describes the registration functions of a bound header and the units it depends on
+    struct RegistrationUnit {
+        const char*         mName;
+        const char*         mHeader;
+        void                (*mDeclarations)( asIScriptEngine* );
+        void                (*mDefinitions)( asIScriptEngine* );
+        //! indices of the units used by this unit signatures, terminated by -1
+        const int*          mDependencies;
+        //! script types declared by this unit, terminated by a null pointer
+        const char* const*  mTypes;
+    };
+    
+    //! returns the index of the unit with that name or -1
+    inline int findRegistrationUnit( const RegistrationUnit* units, size_t count, const std::string &name )
+    {
+        for( size_t i = 0; i < count; i++ ){
+            if( name == units[i].mName || name == units[i].mHeader ){
+                return static_cast<int>( i );
+            }
+        }
+        return -1;
+    }
+    
+    //! returns the index of the unit declaring a script type or -1
+    inline int findRegistrationUnitForType( const RegistrationUnit* units, size_t count, const std::string &typeName )
+    {
+        for( size_t i = 0; i < count; i++ ){
+            for( const char* const* type = units[i].mTypes; *type != nullptr; ++type ){
+                if( typeName == *type ){
+                    return static_cast<int>( i );
+                }
+            }
+        }
+        return -1;
+    }
+    
+    //! returns the closure of the units required by the roots, as a flag per unit
+    inline std::vector<bool> getRegistrationUnitsClosure( const RegistrationUnit* units, size_t count, const std::vector<int> &roots )
+    {
+        std::vector<bool> required( count, false );
+        std::vector<int> stack( roots );
+        
+        while( !stack.empty() ){
+            int index = stack.back();
+            stack.pop_back();
+            
+            if( index < 0 || static_cast<size_t>( index ) >= count || required[index] ){
+                continue;
+            }
+            required[index] = true;
+            
+            for( const int* dependency = units[index].mDependencies; *dependency >= 0; ++dependency ){
+                stack.push_back( *dependency );
+            }
+        }
+        
+        return required;
+    }
+    
+    //! registers the closure of the roots. Every declaration is registered before
+    //! the first definition so the units can reference each other types.
+    inline void registerRegistrationUnits( asIScriptEngine* engine, const RegistrationUnit* units, size_t count, const std::vector<int> &roots )
+    {
+        std::vector<bool> required = getRegistrationUnitsClosure( units, count, roots );
+        
+        for( size_t i = 0; i < count; i++ ){
+            if( required[i] && units[i].mDeclarations ){
+                units[i].mDeclarations( engine );
+            }
+        }
+        for( size_t i = 0; i < count; i++ ){
+            if( required[i] && units[i].mDefinitions ){
+                units[i].mDefinitions( engine );
+            }
+        }
+    }
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <new>
+#include <string>
+
+// Avoid having to inform include path if header is already include before
+#ifndef ANGELSCRIPT_H
+    #include <angelscript.h>
+#endif
+
+namespace as {
+    
+    //! Script value type whose storage is the std::shared_ptr of a Ref typedef. Copying a handle in a
+    //! script copies the shared_ptr, so the object control block is the only reference count involved.
+    template<typename T>
+    struct SharedRef {
+        typedef std::shared_ptr<T> Ptr;
+        
+        static void construct( void* memory ) { new( memory ) Ptr(); }
+        static void copyConstruct( const Ptr &other, void* memory ) { new( memory ) Ptr( other ); }
+        static void destruct( Ptr* ptr ) { ptr->~Ptr(); }
+        
+        static Ptr& assign( Ptr* ptr, const Ptr &other ) { return *ptr = other; }
+        static bool equals( const Ptr* ptr, const Ptr &other ) { return *ptr == other; }
+        static bool isNull( const Ptr* ptr ) { return !*ptr; }
+        static void reset( Ptr* ptr ) { ptr->reset(); }
+        
+        //! returns the object, registered as a reference so the script never holds it without its handle.
+        //! The generator marks T as escaping, its factory handles never count it inside the object
+        static T* get( Ptr* ptr )
+        {
+            if( !*ptr ){
+                if( asIScriptContext* context = asGetActiveContext() ){
+                    context->SetException( "Null Ref access" );
+                }
+            }
+            return ptr->get();
+        }
+    };
+    
+    //! registers the value type of a Ref typedef
+    template<typename T>
+    void registerSharedRefType( asIScriptEngine* engine, const std::string &name )
+    {
+        int r = engine->RegisterObjectType( name.c_str(), sizeof( std::shared_ptr<T> ), asOBJ_VALUE | asGetTypeTraits<std::shared_ptr<T>>() ); assert( r >= 0 );
+    }
+    
+    //! registers the behaviours and methods of a Ref typedef once the type it points to is declared
+    template<typename T>
+    void registerSharedRefMethods( asIScriptEngine* engine, const std::string &name, const std::string &type )
+    {
+        typedef SharedRef<T> Ref;
+        
+        int r;
+        r = engine->RegisterObjectBehaviour( name.c_str(), asBEHAVE_CONSTRUCT, "void f()", asFUNCTION( Ref::construct ), asCALL_CDECL_OBJLAST ); assert( r >= 0 );
+        r = engine->RegisterObjectBehaviour( name.c_str(), asBEHAVE_CONSTRUCT, std::string( "void f( const " + name + " &in )" ).c_str(), asFUNCTION( Ref::copyConstruct ), asCALL_CDECL_OBJLAST ); assert( r >= 0 );
+        r = engine->RegisterObjectBehaviour( name.c_str(), asBEHAVE_DESTRUCT, "void f()", asFUNCTION( Ref::destruct ), asCALL_CDECL_OBJLAST ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), std::string( name + " &opAssign( const " + name + " &in )" ).c_str(), asFUNCTION( Ref::assign ), asCALL_CDECL_OBJFIRST ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), std::string( "bool opEquals( const " + name + " &in ) const" ).c_str(), asFUNCTION( Ref::equals ), asCALL_CDECL_OBJFIRST ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), "bool isNull() const", asFUNCTION( Ref::isNull ), asCALL_CDECL_OBJFIRST ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), "void reset()", asFUNCTION( Ref::reset ), asCALL_CDECL_OBJFIRST ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), std::string( type + " &get()" ).c_str(), asFUNCTION( Ref::get ), asCALL_CDECL_OBJFIRST ); assert( r >= 0 );
+    }
+
+}
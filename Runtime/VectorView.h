@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Avoid having to inform include path if header is already include before
+#ifndef ANGELSCRIPT_H
+    #include <angelscript.h>
+#endif
+
+namespace as {
+    
+    //! Script array type backed by the storage of a std::vector. Views returned by const reference
+    //! point to the vector of their owner and keep it alive, vectors returned by value are moved
+    //! in a shared vector owned by the view. No element is ever copied to cross the boundary, the
+    //! methods whose owner can't be kept alive aren't given a view.
+    template<typename T>
+    class VectorView {
+    public:
+        //! creates a view on a vector owned by another object. The owner reference is released with the view.
+        static VectorView* createView( const std::vector<T> &vector, void* owner, void (*releaseOwner)( void* ) )
+        {
+            VectorView* view        = new VectorView( &vector );
+            view->mOwner            = owner;
+            view->mReleaseOwner     = releaseOwner;
+            return view;
+        }
+        //! creates a view sharing the ownership of a vector returned by value
+        static VectorView* create( std::vector<T> &&vector )
+        {
+            std::shared_ptr<std::vector<T>> shared = std::make_shared<std::vector<T>>( std::move( vector ) );
+            VectorView* view        = new VectorView( shared.get() );
+            view->mShared           = shared;
+            return view;
+        }
+        //! creates an empty vector the scripts can fill before passing it to the bindings
+        static VectorView* create() { return create( std::vector<T>() ); }
+        
+        void addRef() { mRefs.fetch_add( 1, std::memory_order_relaxed ); }
+        void release()
+        {
+            if( mRefs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ){
+                delete this;
+            }
+        }
+        
+        //! returns the vector, used to pass a view back to a binding taking a const std::vector reference
+        const std::vector<T>& get() const { return *mVector; }
+        
+        uint32_t size() const { return static_cast<uint32_t>( mVector->size() ); }
+        bool empty() const { return mVector->empty(); }
+        const T& at( uint32_t index ) const
+        {
+            // the script doesn't read the returned reference once the exception is set but it still has to be valid
+            if( index >= mVector->size() ){
+                setException( "Index out of bounds" );
+                static const T sOutOfBounds = T();
+                return sOutOfBounds;
+            }
+            return ( *mVector )[index];
+        }
+        
+        //! only the vectors owned by the view can be modified
+        void push_back( const T &value ) { if( std::vector<T>* vector = getMutable() ) vector->push_back( value ); }
+        void reserve( uint32_t size ) { if( std::vector<T>* vector = getMutable() ) vector->reserve( size ); }
+        void clear() { if( std::vector<T>* vector = getMutable() ) vector->clear(); }
+    
+    private:
+        explicit VectorView( const std::vector<T>* vector ) : mVector( vector ), mOwner( nullptr ), mReleaseOwner( nullptr ), mRefs( 1 ) {}
+        ~VectorView()
+        {
+            if( mReleaseOwner ){
+                mReleaseOwner( mOwner );
+            }
+        }
+        VectorView( const VectorView& );
+        VectorView& operator=( const VectorView& );
+        
+        std::vector<T>* getMutable()
+        {
+            if( !mShared || mShared.use_count() > 1 ){
+                setException( "Can't modify a view on a bound object storage" );
+                return nullptr;
+            }
+            return mShared.get();
+        }
+        static void setException( const char* message )
+        {
+            if( asIScriptContext* context = asGetActiveContext() ){
+                context->SetException( message );
+            }
+        }
+        
+        const std::vector<T>*               mVector;
+        std::shared_ptr<std::vector<T>>     mShared;
+        void*                               mOwner;
+        void                                (*mReleaseOwner)( void* );
+        std::atomic<uint32_t>               mRefs;
+    };
+    
+    //! registers a vector view type, the name is usually the element type followed by Vector
+    inline void registerVectorViewType( asIScriptEngine* engine, const std::string &name )
+    {
+        int r = engine->RegisterObjectType( name.c_str(), 0, asOBJ_REF ); assert( r >= 0 );
+    }
+    
+    //! registers the behaviours and methods of a vector view type once its element type is declared
+    template<typename T>
+    void registerVectorViewMethods( asIScriptEngine* engine, const std::string &name, const std::string &elementType )
+    {
+        typedef VectorView<T> View;
+        
+        int r;
+        r = engine->RegisterObjectBehaviour( name.c_str(), asBEHAVE_FACTORY, std::string( name + "@ f()" ).c_str(), asFUNCTIONPR( View::create, (), View* ), asCALL_CDECL ); assert( r >= 0 );
+        r = engine->RegisterObjectBehaviour( name.c_str(), asBEHAVE_ADDREF, "void f()", asMETHOD( View, addRef ), asCALL_THISCALL ); assert( r >= 0 );
+        r = engine->RegisterObjectBehaviour( name.c_str(), asBEHAVE_RELEASE, "void f()", asMETHOD( View, release ), asCALL_THISCALL ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), "uint length() const", asMETHOD( View, size ), asCALL_THISCALL ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), "bool isEmpty() const", asMETHOD( View, empty ), asCALL_THISCALL ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), std::string( "const " + elementType + " &opIndex( uint ) const" ).c_str(), asMETHOD( View, at ), asCALL_THISCALL ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), std::string( "void insertLast( const " + elementType + " &in )" ).c_str(), asMETHOD( View, push_back ), asCALL_THISCALL ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), "void reserve( uint )", asMETHOD( View, reserve ), asCALL_THISCALL ); assert( r >= 0 );
+        r = engine->RegisterObjectMethod( name.c_str(), "void removeAll()", asMETHOD( View, clear ), asCALL_THISCALL ); assert( r >= 0 );
+    }
+
+}
@@ -4,9 +4,28 @@
 #include <streambuf>
 #include <algorithm>
 #include <deque>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <numeric>
+
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#if defined( __APPLE__ )
+    #include <mach/mach.h>
+#endif
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
 
 using namespace clang;
 using namespace clang::driver;
@@ -22,226 +41,2568 @@ ClassRef Object::createClass( const std::string &name ) { return ClassRef( new C
 FieldRef Object::createField( const std::string &name ) { return FieldRef( new Field( name ) ); }
 MethodRef Object::createMethod( const std::string &name ) { return MethodRef( new Method( name ) ); }
 
-Parser::Parser( Options options )
-: mOptions( options )
+//! returns the current time in microseconds, the steady clock is shared by the workers processes
+double Parser::Trace::now()
+{
+    return chrono::duration<double,micro>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+//! adds a span to the timeline, tagged with the current header, process and thread
+void Parser::Trace::add( const std::string &name, const std::string &category, double start, double duration )
+{
+    TraceEvent event = { name, category, mHeader, start, duration, static_cast<int>( getpid() ), std::hash<std::thread::id>()( this_thread::get_id() ) };
+    mEvents.push_back( event );
+}
+
+//! forwards a file to the sink, tracing the write
+void Parser::TraceSink::write( const std::string &path, const std::string &content )
+{
+    TraceSpan span( mTrace, "write", "io" );
+    mSink.write( path, content );
+}
+
+//! writes a file, creating its directory if needed
+void Parser::FileSink::write( const std::string &path, const std::string &content )
+{
+    fs::path file = fs::path( mDirectory ) / path;
+    if( !fs::exists( file.parent_path() ) ){
+        fs::create_directories( file.parent_path() );
+    }
+    ofstream stream( file.string() );
+    stream << content;
+}
+//! returns whether a file exists in the directory
+bool Parser::FileSink::exists( const std::string &path ) const
+{
+    return fs::exists( fs::path( mDirectory ) / path );
+}
+//! removes a file of the directory, a missing file is ignored
+void Parser::FileSink::remove( const std::string &path )
+{
+    boost::system::error_code error;
+    fs::remove( fs::path( mDirectory ) / path, error );
+}
+
+//! returns the index of a string in the translation unit string table, adding it if needed
+uint32_t Parser::Output::getBindingStringIndex( const std::string &str )
+{
+    map<string,uint32_t>::iterator it = mBindingStringsIndices.find( str );
+    if( it != mBindingStringsIndices.end() ){
+        return it->second;
+    }
+    
+    uint32_t index = mBindingStrings.size();
+    mBindingStrings.push_back( str );
+    mBindingStringsIndices.insert( make_pair( str, index ) );
+    return index;
+}
+//! returns the number of uncommented registration calls and binding table entries in generated code
+size_t Parser::Output::countRegistrationCalls( const std::string &code )
+{
+    stringstream stream( code );
+    return countRegistrationCalls( stream );
+}
+//! returns the number of uncommented registration calls and binding table entries read from a stream
+size_t Parser::Output::countRegistrationCalls( std::istream &stream )
+{
+    size_t count = 0;
+    string line;
+    while( getline( stream, line ) ){
+        if( line.find( "//" ) == 0 ){
+            continue;
+        }
+        if( line.find( "engine->Register" ) != string::npos || line.find( "{ BindingEntry::" ) != string::npos || line.find( "registrar." ) != string::npos ){
+            count++;
+        }
+    }
+    return count;
+}
+
+Parser::Parser( Options options )
+: mOptions( options )
+{
+    mTrace.mEnabled = mOptions.isTraceEnabled();
+}
+
+//! runs the whole generator, parsing every header and writing the bindings to the output directory
+void Parser::run()
+{
+    vector<string> headers;
+    {
+        TraceSpan span( &mTrace, "discovery", "run" );
+        headers = findHeaders();
+    }
+    
+    FileSink sink( mOptions.getOutputDirectory() );
+    emit( parse( headers ), sink );
+}
+
+//! returns the input file list, or the headers found in the input directory
+std::vector<std::string> Parser::findHeaders() const
+{
+    vector<string> inputs = mOptions.getInputFileList();
+    
+    fs::path inputDirectory = mOptions.getInputDirectory();
+    
+    // if there's no inputFileList, recursively walk the inputDirectory
+    if( inputs.empty() ){
+        const vector<string>& excludeDirectories = mOptions.getExcludeDirectoryList();
+        fs::recursive_directory_iterator dir( inputDirectory ), end;
+        while ( dir != end )
+        {
+            const fs::path& current = dir->path();
+            
+            // skip .DS_Store and excludedDirectories
+            if( current.filename() == ".DS_Store" ||
+               find( excludeDirectories.begin(), excludeDirectories.end(), current.string() ) != excludeDirectories.end() ){
+                dir.no_push();
+            }
+            // if we find a head, add it to the inputList
+            else if( !fs::is_directory( current ) && current.extension() == ".h" ){
+                inputs.push_back( current.string() );
+            }
+            
+            ++dir;
+        }
+    }
+    
+    // every node of a sharded run has to see the headers in the same order
+    if( mOptions.getInputFileList().empty() ){
+        sort( inputs.begin(), inputs.end() );
+    }
+    
+    return inputs;
+}
+
+//! parses the headers, reusing the ones the include graph or the shards records allow to skip
+Parser::Model Parser::parse( const std::vector<std::string> &files )
+{
+    vector<fs::path> inputs( files.begin(), files.end() );
+    Model model;
+    
+    // the file manager caches the files stats between the parses unless one of the files changed
+    if( !mFileManager || !getChangedFiles().empty() ){
+        mFileManager = new FileManager( FileSystemOptions() );
+    }
+    
+    // the merge step reuses the headers parsed by the shards
+    set<string> invalidatedHeaders;
+    if( mOptions.isMergeEnabled() ){
+        vector<fs::path> shardFiles;
+        for( fs::directory_iterator file( mOptions.getOutputDirectory() ), end; file != end; ++file ){
+            if( boost::starts_with( file->path().filename().string(), "CinderShard" ) && file->path().extension() == ".txt" ){
+                shardFiles.push_back( file->path() );
+            }
+        }
+        sort( shardFiles.begin(), shardFiles.end() );
+        for( auto shardFile : shardFiles ){
+            readIncludeGraph( shardFile.string() );
+            model.mMergedShards.push_back( shardFile.filename().string() );
+        }
+    }
+    // only the headers whose include graph changed since the last run are parsed again
+    else if( mOptions.isIncrementalEnabled() ){
+        readIncludeGraph( mOptions.getOutputDirectory() + "/CinderIncludeGraph.txt" );
+        invalidatedHeaders = getInvalidatedHeaders( getChangedFiles() );
+    }
+    
+    // only emit what the scripts can reach, the symbols are collected once and kept with the graph
+    if( !mOptions.getScriptDirectory().empty() && !mUsage.mEnabled ){
+        // the types are reachable through every header, not only the ones given to this parse
+        vector<string> discoveredHeaders = findHeaders();
+        vector<fs::path> usageInputs( discoveredHeaders.begin(), discoveredHeaders.end() );
+        if( mCachedUsage.mEnabled && mCachedUsage.mInputsKey == Usage::getInputsKey( usageInputs ) && getChangedFiles().empty() ){
+            mUsage = mCachedUsage;
+        }
+        else {
+            collectUsage( usageInputs );
+            
+            // the reused bindings were pruned by the previous usage
+            if( mUsage.mTypes != mCachedUsage.mTypes || mUsage.mIdentifiers != mCachedUsage.mIdentifiers ){
+                mCachedRecords.clear();
+            }
+        }
+    }
+    
+    set<string> shardHeaders;
+    if( mOptions.isSharded() ){
+        shardHeaders = getShardHeaders( inputs );
+    }
+    
+    vector<fs::path> headers;
+    for( auto path : inputs ){
+        if( mOptions.isSharded() && !shardHeaders.count( path.string() ) ){
+            continue;
+        }
+        
+        // the bindings depend on every header, even the ones without a record
+        boost::system::error_code error;
+        fs::path canonicalPath = fs::canonical( path, error );
+        model.mHeaders.push_back( error ? path.string() : canonicalPath.string() );
+        
+        // forwarding, macro only or empty headers are skipped without running clang
+        if( mOptions.isPrefilterEnabled() ){
+            std::ifstream file( path.c_str() );
+            std::string code((std::istreambuf_iterator<char>(file)),
+                             std::istreambuf_iterator<char>());
+            if( !hasDeclarations( code ) ){
+                model.mSkippedHeaders.push_back( path.string() );
+                continue;
+            }
+        }
+        headers.push_back( path );
+    }
+    if( !model.mSkippedHeaders.empty() ){
+        cout << "Skipped " << model.mSkippedHeaders.size() << " of " << ( headers.size() + model.mSkippedHeaders.size() ) << " headers without declarations" << endl;
+    }
+    
+    // in a worker pool the headers are parsed first and the workers send their bindings back
+    map<string,HeaderRecord> parsedRecords;
+    set<string> failedHeaders;
+    if( mOptions.getWorkers() ){
+        vector<fs::path> jobs;
+        for( auto path : headers ){
+            if( !isReusable( path, invalidatedHeaders ) ){
+                jobs.push_back( path );
+            }
+        }
+        parseInWorkers( jobs, &parsedRecords, &failedHeaders, &model.mFiles );
+    }
+    
+    // run clang tool on each header
+    for( auto path : headers ){
+        string canonicalPath = fs::canonical( path ).string();
+        
+        // a header that crashed or timed out twice is reported and left out of the bindings
+        if( failedHeaders.count( canonicalPath ) ){
+            model.mFailedHeaders.push_back( path.string() );
+            continue;
+        }
+        
+        // reuse the header parsed by a worker or the previous run files, the bindings ids are offsets assigned at emit
+        auto parsedRecord = parsedRecords.find( canonicalPath );
+        if( parsedRecord != parsedRecords.end() ){
+            model.mRecords.push_back( parsedRecord->second );
+            continue;
+        }
+        else if( isReusable( path, invalidatedHeaders ) ){
+            model.mRecords.push_back( mCachedRecords.find( canonicalPath )->second );
+            continue;
+        }
+        
+        shared_ptr<Output> output;
+        HeaderRecord record = parseHeader( path, &output );
+        model.mRecords.push_back( record );
+        model.mOutputs[canonicalPath] = output;
+    }
+    
+    for( auto header : model.mFailedHeaders ){
+        cerr << "Failed to parse " << header << ", it has no bindings" << endl;
+    }
+    
+    // a file changed between the parse and the emit is still seen as changed by the next run
+    model.mFileStamps = getFileStamps( model.mRecords );
+    
+    return model;
+}
+
+//! returns whether a registration code assigns the result of a call, the commented calls don't
+bool Parser::assignsResult( const std::string &code )
+{
+    stringstream lines( code );
+    string line;
+    while( getline( lines, line ) ){
+        size_t first = line.find_first_not_of( "\t " );
+        if( first != string::npos && line.compare( first, 4, "r = " ) == 0 ){
+            return true;
+        }
+    }
+    return false;
+}
+
+//! returns whether a header declares a class, an enum, a function or a typedef itself, the includes aren't followed
+bool Parser::hasDeclarations( const std::string &code )
+{
+    LangOptions langOptions;
+    langOptions.CPlusPlus   = true;
+    langOptions.CPlusPlus11 = true;
+    Lexer lexer( SourceLocation(), langOptions, code.c_str(), code.c_str(), code.c_str() + code.size() );
+    
+    // the tokens of the file without its preprocessor directives
+    vector<Token> tokens;
+    bool isInDirective = false;
+    Token token;
+    lexer.LexFromRawLexer( token );
+    while( token.isNot( tok::eof ) ){
+        if( token.isAtStartOfLine() ){
+            isInDirective = token.is( tok::hash );
+        }
+        if( !isInDirective ){
+            tokens.push_back( token );
+        }
+        lexer.LexFromRawLexer( token );
+    }
+    
+    for( size_t i = 0; i < tokens.size(); i++ ){
+        if( tokens[i].isNot( tok::raw_identifier ) ){
+            continue;
+        }
+        
+        StringRef identifier( tokens[i].getRawIdentifierData(), tokens[i].getLength() );
+        // forward declarations don't produce bindings, only the types with a body do
+        if( identifier == "class" || identifier == "struct" || identifier == "union" || identifier == "enum" ){
+            for( size_t j = i + 1; j < tokens.size() && tokens[j].isNot( tok::semi ); j++ ){
+                if( tokens[j].is( tok::l_brace ) ){
+                    return true;
+                }
+            }
+        }
+        // typedefs can bind Ref types and templates specializations
+        else if( identifier == "typedef" || ( identifier == "using" && !( i + 1 < tokens.size() && tokens[i + 1].is( tok::raw_identifier ) &&
+                                                                          StringRef( tokens[i + 1].getRawIdentifierData(), tokens[i + 1].getLength() ) == "namespace" ) ) ){
+            return true;
+        }
+        // a function declaration, a macro call looks the same without preprocessing so it's parsed too
+        else if( i + 1 < tokens.size() && tokens[i + 1].is( tok::l_paren ) ){
+            return true;
+        }
+    }
+    return false;
+}
+
+//! returns the path of the generated files of a header, without extension and relative to the output directory
+std::string Parser::getOutputPath( const boost::filesystem::path &path ) const
+{
+    std::string currentDirName = path.parent_path().string();
+    boost::replace_all( currentDirName, mOptions.getInputDirectory(), "" );
+    
+    if( !currentDirName.empty() && currentDirName[0] == '/' ){
+        currentDirName = currentDirName.substr( 1 );
+    }
+    return ( currentDirName.empty() ? "" : currentDirName + "/" ) + path.stem().string();
+}
+
+//! returns whether the previous run files of a header can be reused, nothing it includes changed and its files still exist
+bool Parser::isReusable( const boost::filesystem::path &path, const std::set<std::string> &invalidatedHeaders ) const
+{
+    if( !mOptions.isIncrementalEnabled() && !mOptions.isMergeEnabled() ){
+        return false;
+    }
+    
+    string canonicalPath    = fs::canonical( path ).string();
+    string outputPath       = mOptions.getOutputDirectory() + "/" + getOutputPath( path );
+    return mCachedRecords.count( canonicalPath ) && !invalidatedHeaders.count( canonicalPath ) && fs::exists( outputPath + ".cpp" ) && fs::exists( outputPath + ".h" );
+}
+
+//! parses a header and returns its record, the output keeps the generated code until it is written
+Parser::HeaderRecord Parser::parseHeader( const boost::filesystem::path &path, std::shared_ptr<Output> *output )
+{
+    fs::path name           = path.filename();
+    string outputPath       = getOutputPath( path );
+    string currentDirName   = fs::path( outputPath ).parent_path().string();
+    string canonicalPath    = fs::canonical( path ).string();
+    
+    mTrace.mHeader = ( currentDirName.empty() ? "" : currentDirName + "/" ) + name.string();
+    std::string code;
+    {
+        TraceSpan span( &mTrace, "read", "io" );
+        std::ifstream file( path.c_str() );
+        code = std::string((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    }
+    
+    // cout << "Parsing " << ( currentDirName.empty() ? "/" : currentDirName + "/" ) + name.string() << endl;
+    
+    output->reset( new Output() );
+    ( *output )->mBindingIdBase = getBindingIdBase( name.stem().string() );
+    ( *output )->mTrace         = mTrace.mEnabled ? &mTrace : nullptr;
+    
+    size_t rssBefore = mOptions.isMemoryReportEnabled() ? getResidentMemory() : 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    {
+        TraceSpan span( &mTrace, "frontend", "clang" );
+        runTool( new FrontendAction( **output, mOptions, mUsage ), code, name.string() );
+    }
+    double toolTime = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+    
+    // keep what the header adds to the shared files so the next runs can skip it
+    HeaderRecord record;
+    record.mPath                    = canonicalPath;
+    record.mName                    = name.stem().string();
+    record.mHeader                  = ( currentDirName.empty() ? "" : currentDirName + "/" ) + name.string();
+    record.mOutputPath              = outputPath;
+    record.mHasDeclarations         = ( *output )->mDeclCalls.tellp() || ( *output )->mEnumsDecl.tellp();
+    record.mHasDefinitions          = ( *output )->mDefCalls.tellp();
+    record.mHasTemplates            = ( *output )->mTemplatesDef.tellp();
+    record.mTypes                   = ( *output )->mDeclaredTypes;
+    record.mCountedBindings         = ( *output )->mCountedBindings;
+    record.mVectorViews             = ( *output )->mVectorViews;
+    record.mFactoryTypes            = ( *output )->mFactoryTypes;
+    record.mEscapingTypes           = ( *output )->mEscapingTypes;
+    record.mTemplateInstantiations  = ( *output )->mTemplateInstantiations;
+    record.mParseTime               = std::max( 0.0, toolTime - ( *output )->mVisitTime );
+    record.mVisitTime               = ( *output )->mVisitTime;
+    
+    // the output sections are kept until the header is emitted
+    if( mOptions.isMemoryReportEnabled() ){
+        Output &out = **output;
+        record.mMemory              = out.mMemory;
+        record.mMemory.mRssBefore   = rssBefore;
+        record.mMemory.mRssAfter    = getResidentMemory();
+        vector<pair<string,stringstream*>> sections = {
+            { "ClassDecl", &out.mClassDecl }, { "ClassDef", &out.mClassDef }, { "ClassExtras", &out.mClassExtras }, { "Wrappers", &out.mWrappers },
+            { "ClassFieldDecl", &out.mClassFieldDecl }, { "ClassFieldDef", &out.mClassFieldDef }, { "ClassMethodDecl", &out.mClassMethodDecl }, { "ClassMethodDef", &out.mClassMethodDef },
+            { "TemplatesDecl", &out.mTemplatesDecl }, { "TemplatesDef", &out.mTemplatesDef }, { "TemplatesExtras", &out.mTemplatesExtras }, { "TemplateDeclCalls", &out.mTemplateDeclCalls },
+            { "EnumsDecl", &out.mEnumsDecl }, { "EnumsExtras", &out.mEnumsExtras }, { "FunctionDef", &out.mFunctionDef }, { "DeclCalls", &out.mDeclCalls }, { "DefCalls", &out.mDefCalls }
+        };
+        for( auto section : sections ){
+            streamoff size = section.second->tellp();
+            if( size > 0 ){
+                record.mMemory.mSections[section.first] = static_cast<size_t>( size );
+                record.mMemory.mOutputBytes += static_cast<size_t>( size );
+            }
+        }
+    }
+    for( auto dependency : ( *output )->mDependencies ){
+        boost::system::error_code error;
+        fs::path canonicalDependency = fs::canonical( dependency, error );
+        record.mDependencies.insert( error ? dependency : canonicalDependency.string() );
+    }
+    for( auto include : ( *output )->mIncludes ){
+        boost::system::error_code includerError, pathError;
+        IncludeEdge edge    = include;
+        fs::path includer   = include.mIncluder.empty() ? fs::path() : fs::canonical( include.mIncluder, includerError );
+        fs::path included   = include.mPath.empty() ? fs::path() : fs::canonical( include.mPath, pathError );
+        edge.mIncluder      = include.mIncluder.empty() ? canonicalPath : ( includerError ? include.mIncluder : includer.string() );
+        edge.mPath          = pathError ? include.mPath : included.string();
+        record.mIncludes.push_back( edge );
+    }
+    return record;
+}
+
+//! parses the headers in forked workers, a crashed or timed out header is retried once before being reported as failed
+void Parser::parseInWorkers( const std::vector<boost::filesystem::path> &headers, std::map<std::string,HeaderRecord> *records, std::set<std::string> *failedHeaders, std::map<std::string,std::string> *files )
+{
+    struct Worker {
+        Worker() : mPid( -1 ), mJobs( -1 ), mResults( -1 ), mJob( -1 ), mJobsDone( 0 ) {}
+        
+        pid_t       mPid;
+        int         mJobs;
+        int         mResults;
+        int         mJob;
+        size_t      mJobsDone;
+        string      mBuffer;
+        chrono::steady_clock::time_point mStart;
+    };
+    
+    // a worker that died closes its pipe, the parent must not be killed writing to it until the workers are done
+    void (*previousSigPipe)( int ) = signal( SIGPIPE, SIG_IGN );
+    cout.flush();
+    cerr.flush();
+    
+    // the most expensive headers are started first so they don't end the run alone
+    readTimings();
+    double costPerByte = getCostPerByte();
+    vector<pair<double,int>> costs;
+    for( int i = 0; i < headers.size(); i++ ){
+        costs.push_back( make_pair( getEstimatedCost( headers[i], costPerByte ), i ) );
+    }
+    stable_sort( costs.begin(), costs.end(), []( const pair<double,int> &a, const pair<double,int> &b ){ return a.first > b.first; } );
+    deque<int> pending;
+    for( auto cost : costs ){
+        pending.push_back( cost.second );
+    }
+    map<int,int> attempts;
+    vector<Worker> workers( std::min<size_t>( mOptions.getWorkers(), std::max<size_t>( headers.size(), 1 ) ) );
+    
+    // stops a worker, the job it was running failed if there's one
+    auto stopWorker = [&]( Worker &worker, bool kill ){
+        if( kill && worker.mPid > 0 ){
+            ::kill( worker.mPid, SIGKILL );
+        }
+        close( worker.mJobs );
+        close( worker.mResults );
+        if( worker.mPid > 0 ){
+            waitpid( worker.mPid, nullptr, 0 );
+        }
+        if( worker.mJob >= 0 && ++attempts[worker.mJob] < 2 ){
+            pending.push_back( worker.mJob );
+        }
+        else if( worker.mJob >= 0 ){
+            failedHeaders->insert( fs::canonical( headers[worker.mJob] ).string() );
+        }
+        worker = Worker();
+    };
+    
+    // once a worker can't be started the headers left are parsed in process by parse
+    bool canStartWorkers = true;
+    while( true ){
+        // start the workers and give a header to the idle ones
+        for( auto &worker : workers ){
+            if( worker.mJob >= 0 || pending.empty() || ( worker.mPid < 0 && !canStartWorkers ) ){
+                continue;
+            }
+            if( worker.mPid < 0 ){
+                int jobsPipe[2] = { -1, -1 }, resultsPipe[2] = { -1, -1 };
+                pid_t pid = -1;
+                if( pipe( jobsPipe ) == 0 && pipe( resultsPipe ) == 0 ){
+                    pid = fork();
+                }
+                if( pid < 0 ){
+                    cerr << "Can't start a worker, the remaining headers are parsed in process" << endl;
+                    for( int fd : { jobsPipe[0], jobsPipe[1], resultsPipe[0], resultsPipe[1] } ){
+                        if( fd >= 0 ){
+                            close( fd );
+                        }
+                    }
+                    canStartWorkers = false;
+                    continue;
+                }
+                if( pid == 0 ){
+                    for( auto &other : workers ){
+                        if( other.mPid > 0 ){
+                            close( other.mJobs );
+                            close( other.mResults );
+                        }
+                    }
+                    close( jobsPipe[1] );
+                    close( resultsPipe[0] );
+                    runWorker( headers, jobsPipe[0], resultsPipe[1] );
+                    _exit( 0 );
+                }
+                close( jobsPipe[0] );
+                close( resultsPipe[1] );
+                worker.mPid     = pid;
+                worker.mJobs    = jobsPipe[1];
+                worker.mResults = resultsPipe[0];
+            }
+            
+            worker.mJob     = pending.front();
+            worker.mStart   = chrono::steady_clock::now();
+            pending.pop_front();
+            string job = to_string( worker.mJob ) + "\n";
+            if( ::write( worker.mJobs, job.c_str(), job.size() ) != static_cast<ssize_t>( job.size() ) ){
+                stopWorker( worker, true );
+            }
+        }
+        
+        // wait for a result, at most until the first timeout
+        vector<pollfd> fds;
+        vector<Worker*> busyWorkers;
+        int timeout = -1;
+        for( auto &worker : workers ){
+            if( worker.mJob < 0 ){
+                continue;
+            }
+            fds.push_back( { worker.mResults, POLLIN, 0 } );
+            busyWorkers.push_back( &worker );
+            if( mOptions.getWorkerTimeout() > 0 ){
+                double elapsed      = chrono::duration<double>( chrono::steady_clock::now() - worker.mStart ).count();
+                int remaining       = static_cast<int>( std::max( 0.0, mOptions.getWorkerTimeout() - elapsed ) * 1000 ) + 1;
+                timeout             = timeout < 0 ? remaining : std::min( timeout, remaining );
+            }
+        }
+        if( fds.empty() && ( pending.empty() || !canStartWorkers ) ){
+            break;
+        }
+        else if( fds.empty() ){
+            continue;
+        }
+        poll( fds.data(), fds.size(), timeout );
+        
+        for( size_t i = 0; i < fds.size(); i++ ){
+            Worker &worker = *busyWorkers[i];
+            
+            // checked on every poll, a worker that keeps writing output is timed out too
+            if( mOptions.getWorkerTimeout() > 0 && chrono::duration<double>( chrono::steady_clock::now() - worker.mStart ).count() > mOptions.getWorkerTimeout() ){
+                stopWorker( worker, true );
+                continue;
+            }
+            
+            if( fds[i].revents & ( POLLIN | POLLHUP | POLLERR ) ){
+                char buffer[4096];
+                ssize_t size = read( worker.mResults, buffer, sizeof( buffer ) );
+                // the worker crashed during the job
+                if( size <= 0 ){
+                    stopWorker( worker, false );
+                    continue;
+                }
+                worker.mBuffer.append( buffer, size );
+                
+                // the job is done once the worker sent its memory usage and the bindings it announced
+                size_t end = worker.mBuffer.find( "\ndone\t" );
+                size_t lineEnd = end == string::npos ? string::npos : worker.mBuffer.find( '\n', end + 1 );
+                if( lineEnd == string::npos ){
+                    continue;
+                }
+                string doneLine = worker.mBuffer.substr( end + 1, lineEnd - end - 1 );
+                vector<string> done;
+                boost::split( done, doneLine, boost::is_any_of( "\t" ) );
+                size_t rss          = stoul( done[1] );
+                size_t filesBytes   = done.size() > 2 ? stoul( done[2] ) : 0;
+                if( worker.mBuffer.size() < lineEnd + 1 + filesBytes ){
+                    continue;
+                }
+                
+                // every file is sent as its path and size followed by its content
+                for( size_t offset = lineEnd + 1; offset < lineEnd + 1 + filesBytes; ){
+                    size_t headerEnd    = worker.mBuffer.find( '\n', offset );
+                    size_t separator    = worker.mBuffer.rfind( '\t', headerEnd );
+                    size_t fileSize     = stoul( worker.mBuffer.substr( separator + 1, headerEnd - separator - 1 ) );
+                    ( *files )[worker.mBuffer.substr( offset, separator - offset )] = worker.mBuffer.substr( headerEnd + 1, fileSize );
+                    offset = headerEnd + 1 + fileSize;
+                }
+                
+                stringstream result( worker.mBuffer.substr( 0, end + 1 ) );
+                string line;
+                HeaderRecord* record = nullptr;
+                while( getline( result, line ) ){
+                    vector<string> fields;
+                    boost::split( fields, line, boost::is_any_of( "\t" ) );
+                    if( fields[0] == "trace" && fields.size() == 8 ){
+                        TraceEvent event = { fields[1], fields[2], fields[3], stod( fields[4] ), stod( fields[5] ), stoi( fields[6] ), stoul( fields[7] ) };
+                        mTrace.mEvents.push_back( event );
+                    }
+                    else {
+                        record = readHeaderRecordLine( fields, *records, record );
+                    }
+                }
+                
+                // recycle the worker after a number of jobs or once its memory grew over the limit
+                worker.mJob = -1;
+                worker.mBuffer.clear();
+                worker.mJobsDone++;
+                if( ( mOptions.getWorkerJobs() && worker.mJobsDone >= mOptions.getWorkerJobs() ) ||
+                   ( mOptions.getWorkerMemoryLimit() && rss > mOptions.getWorkerMemoryLimit() * 1024 * 1024 ) ){
+                    stopWorker( worker, false );
+                }
+            }
+        }
+    }
+    
+    // the idle workers exit once their jobs pipe is closed
+    for( auto &worker : workers ){
+        if( worker.mPid > 0 ){
+            stopWorker( worker, false );
+        }
+    }
+    signal( SIGPIPE, previousSigPipe );
+}
+
+//! parses the headers sent by the parent process and sends back their bindings until its jobs pipe is closed
+void Parser::runWorker( const std::vector<boost::filesystem::path> &headers, int jobs, int results )
+{
+    // a runaway header fails its allocations instead of growing until the machine swaps
+    if( mOptions.getWorkerMemoryLimit() ){
+        struct rlimit limit;
+        limit.rlim_cur = limit.rlim_max = mOptions.getWorkerMemoryLimit() * 1024 * 1024 * 2;
+        setrlimit( RLIMIT_DATA, &limit );
+    }
+    
+    // the spans recorded by the parent before the fork are already in its trace
+    mTrace.mEvents.clear();
+    
+    FILE* jobsFile = fdopen( jobs, "r" );
+    int job;
+    while( fscanf( jobsFile, "%d", &job ) == 1 ){
+        // the bindings are sent to the parent, which writes them through the sink given to emit
+        MemorySink sink;
+        shared_ptr<Output> output;
+        HeaderRecord record = parseHeader( headers[job], &output );
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        writeHeader( record, *output, sink );
+        record.mEmitTime = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+        
+        // the peak resident size is in bytes on osx and in kilobytes on linux
+        struct rusage usage;
+        getrusage( RUSAGE_SELF, &usage );
+#if defined( __APPLE__ )
+        size_t rss = usage.ru_maxrss;
+#else
+        size_t rss = usage.ru_maxrss * 1024;
+#endif
+        
+        stringstream result;
+        result << endl;
+        writeHeaderRecord( result, record );
+        for( auto event : mTrace.mEvents ){
+            result << "trace" << "\t" << event.mName << "\t" << event.mCategory << "\t" << event.mHeader << "\t" << fixed << event.mStart << "\t" << event.mDuration << "\t" << event.mProcess << "\t" << event.mThread << endl;
+        }
+        mTrace.mEvents.clear();
+        
+        string files;
+        for( auto file : sink.getFiles() ){
+            files += file.first + "\t" + to_string( file.second.size() ) + "\n" + file.second;
+        }
+        result << "done" << "\t" << rss << "\t" << files.size() << endl;
+        result << files;
+        
+        string data = result.str();
+        for( size_t written = 0; written < data.size(); ){
+            ssize_t size = ::write( results, data.c_str() + written, data.size() - written );
+            if( size <= 0 ){
+                _exit( 1 );
+            }
+            written += size;
+        }
+    }
+    fclose( jobsFile );
+    close( results );
+}
+
+//! writes the bindings of the parsed headers and the files shared by every header
+void Parser::emit( const Model &model, Sink &sink )
+{
+    // the files writes are traced through the sink
+    TraceSink traceSink( sink, &mTrace );
+    
+    // the workers sent the bindings of their headers back with their records
+    for( auto file : model.mFiles ){
+        traceSink.write( file.first, file.second );
+    }
+    
+    // the shared files are built again from the records of every header
+    mUnits.clear();
+    mCountedBindings.clear();
+    mVectorViews.clear();
+    mVectorViewsHeaders.clear();
+    mFactoryTypes.clear();
+    mEscapingTypes.clear();
+    mTemplateInstantiations.clear();
+    mTemplatesHeaders.clear();
+    mTemplatesInlines.clear();
+    
+    // a model of a few headers only replaces their records, the shared files keep the other headers
+    vector<HeaderRecord> records = getMergedRecords( model, traceSink );
+    mRecords.clear();
+    
+    stringstream globalDeclCalls;
+    stringstream globalDefCalls;
+    stringstream globalIncludes;
+    
+    for( auto record : records ){
+        auto output = model.mOutputs.find( record.mPath );
+        if( output != model.mOutputs.end() ){
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            writeHeader( record, *output->second, traceSink );
+            record.mEmitTime = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+        }
+        addHeaderRecord( record, globalIncludes, globalDeclCalls, globalDefCalls );
+    }
+    mTrace.mHeader.clear();
+    
+    // the stamps tell the next parse whether its caches are still valid
+    updateFileStamps( model );
+    
+    // the shared files need every header, they are written by the merge step
+    if( mOptions.isSharded() ){
+        string shard = to_string( mOptions.getShardIndex() ) + "of" + to_string( mOptions.getShardCount() );
+        writeIncludeGraph( "CinderShard" + shard + ".txt", traceSink );
+        if( mTrace.mEnabled ){
+            writeTrace( "CinderTrace" + shard + ".json", sink );
+        }
+        return;
+    }
+    // only the workers scheduling reads the times, the shards send theirs with their records to the merge step
+    if( mOptions.getWorkers() ){
+        writeTimings( traceSink );
+    }
+    
+    TraceSpan span( &mTrace, "emit shared files", "emit" );
+    if( mOptions.isIncrementalEnabled() ){
+        writeIncludeGraph( "CinderIncludeGraph.txt", traceSink );
+    }
+    if( mOptions.isDepfilesEnabled() ){
+        writeDepfiles( model, traceSink );
+    }
+    if( mOptions.isRegistrationUnitsEnabled() ){
+        writeRegistrationUnits( traceSink );
+    }
+    if( mOptions.isCallCountersEnabled() ){
+        writeBindingCounters( traceSink );
+    }
+    if( !mTemplateInstantiations.empty() ){
+        writeTemplateInstantiations( traceSink );
+    }
+    if( mOptions.isThreadSafeFactoriesEnabled() || mOptions.isPooledFactoriesEnabled() ){
+        writeFactoryTypes( traceSink );
+    }
+    if( !mVectorViews.empty() ){
+        writeVectorViews( traceSink );
+        
+        // the views methods need the elements types so they are defined last
+        globalIncludes << "#include \"CinderVectorViews.h\"" << endl;
+        globalDeclCalls << "\t" << "as::registerCinderVectorViewsDeclarations( engine );" << endl;
+        globalDefCalls << "\t" << "as::registerCinderVectorViewsDefinitions( engine );" << endl;
+    }
+    
+    writeRegistry( globalIncludes.str(), globalDeclCalls.str(), globalDefCalls.str(), traceSink );
+    
+    // a merged shard record could be reused by a later merge after its header changed, they are only
+    // removed once the shared files built from them are written
+    for( auto shardFile : model.mMergedShards ){
+        traceSink.remove( shardFile );
+    }
+    
+    cout << globalIncludes.str() << endl << endl << globalDeclCalls.str() << endl << endl << globalDefCalls.str() << endl;
+    
+    if( mTrace.mEnabled ){
+        writeTrace( "CinderTrace.json", sink );
+    }
+    if( mOptions.isMemoryReportEnabled() ){
+        printMemoryReport();
+    }
+}
+
+//! runs a frontend action on a header, like runToolOnCodeWithArgs but sharing the file manager between the headers
+bool Parser::runTool( clang::FrontendAction* action, const std::string &code, const std::string &fileName )
+{
+    vector<string> arguments = { "clang-tool", "-fsyntax-only" };
+    arguments.insert( arguments.end(), mOptions.getCompilerFlags().begin(), mOptions.getCompilerFlags().end() );
+    arguments.push_back( fileName );
+    
+    ToolInvocation invocation( arguments, action, mFileManager.getPtr() );
+    invocation.mapVirtualFile( fileName, code );
+    return invocation.run();
+}
+
+//! writes the bindings of a parsed header
+void Parser::writeHeader( const HeaderRecord &record, Output &output, Sink &sink )
+{
+    mTrace.mHeader = record.mHeader;
+    TraceSpan span( &mTrace, "emit", "emit" );
+    
+    fs::path name           = fs::path( record.mHeader ).filename();
+    string currentDirName   = fs::path( record.mHeader ).parent_path().string();
+    
+    stringstream sourceFile;
+    stringstream headerFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        sourceFile << mOptions.getLicense() << endl;
+        sourceFile << endl;
+        headerFile << mOptions.getLicense() << endl;
+        headerFile << endl;
+    }
+    
+    // Header Header
+    headerFile << "#pragma once" << endl;
+    headerFile << endl;
+    if( output.mTemplatesDecl.tellp() ){
+        headerFile << "#include <string>" << endl;
+        headerFile << endl;
+    }
+    headerFile << "class asIScriptEngine;" << endl;
+    headerFile << endl;
+    headerFile << "namespace as {" << endl;
+    headerFile << endl;
+    
+    
+    // Source Header
+    sourceFile << "#include \"" << name.string() << "\"" << endl;
+    sourceFile << endl;
+    sourceFile << "// Avoid having to inform include path if header is already include before" << endl;
+    sourceFile << "#ifndef ANGELSCRIPT_H" << endl;
+    sourceFile << "\t" << "#include <angelscript.h>" << endl;
+    sourceFile << "#endif" << endl;
+    sourceFile << endl;
+    sourceFile << "#include \"RegistrationHelper.h\"" << endl;
+    if( mOptions.isTableRegistrationEnabled() ){
+        sourceFile << "#include \"BindingTable.h\"" << endl;
+    }
+    if( mOptions.isThreadSafeFactoriesEnabled() || mOptions.isPooledFactoriesEnabled() ){
+        sourceFile << "#include \"RefCounted.h\"" << endl;
+        sourceFile << "#include \"CinderFactoryTypes.h\"" << endl;
+    }
+    if( mOptions.isPooledFactoriesEnabled() ){
+        sourceFile << "#include \"FactoryPool.h\"" << endl;
+    }
+    if( mOptions.isRegistrationProfilingEnabled() ){
+        sourceFile << "#include \"RegistrationProfile.h\"" << endl;
+    }
+    if( mOptions.isCallCountersEnabled() ){
+        sourceFile << "#include \"CinderBindingCounters.h\"" << endl;
+    }
+    if( !output.mVectorViews.empty() ){
+        sourceFile << "#include \"VectorView.h\"" << endl;
+    }
+    if( output.mHasSharedRefs ){
+        sourceFile << "#include \"SharedRef.h\"" << endl;
+    }
+    if( mOptions.isRegistrarEmitterEnabled() ){
+        sourceFile << "#include \"Registrar.h\"" << endl;
+    }
+    sourceFile << "#include \"" << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << "\"" << endl;
+    sourceFile << endl;
+    
+    sourceFile << endl;
+    sourceFile << "using namespace std;" << endl;
+    sourceFile << "using namespace ci;" << endl;
+    sourceFile << endl;
+    sourceFile << "namespace as {" << endl;
+    sourceFile << endl;
+    
+    // Registration profile, the class entries come first as the calls already use their indices
+    map<string,size_t> headerProfileIndices;
+    if( mOptions.isRegistrationProfilingEnabled() && ( output.mDeclCalls.tellp() || output.mEnumsDecl.tellp() || output.mDefCalls.tellp() ) ){
+        string header = "cinder/" + currentDirName + ( currentDirName.empty() ? "" : "/" ) + name.string();
+        
+        sourceFile << "\t" << "//! " << name.string() << " registration profile" << endl;
+        sourceFile << "\t" << "static RegistrationProfileCounter sRegistrationProfile[] = {" << endl;
+        
+        size_t declarationsCount    = Output::countRegistrationCalls( output.mEnumsDecl.str() );
+        size_t definitionsCount     = Output::countRegistrationCalls( output.mFunctionDef.str() );
+        for( auto entry : output.mProfileEntries ){
+            size_t count = output.mRegistrationCounts[entry.mFunction];
+            if( boost::ends_with( entry.mFunction, "Type" ) ){
+                declarationsCount += count;
+            }
+            else {
+                definitionsCount += count;
+            }
+            sourceFile << "\t\t" << "{ \"" << header << "\", \"" << entry.mClass << "\", \"" << entry.mFunction << "\", RegistrationProfileEntry::Class, " << count << ", {}, {} }," << endl;
+        }
+        
+        // the enums and functions are called by the declarations and definitions so they are only reported as parts
+        vector<pair<string,size_t>> headerEntries;
+        if( output.mDeclCalls.tellp() || output.mEnumsDecl.tellp() ) headerEntries.push_back( make_pair( "Declarations", declarationsCount ) );
+        if( output.mDefCalls.tellp() ) headerEntries.push_back( make_pair( "Definitions", definitionsCount ) );
+        if( output.mEnumsDecl.tellp() ) headerEntries.push_back( make_pair( "Enums", Output::countRegistrationCalls( output.mEnumsDecl.str() ) ) );
+        if( output.mFunctionDef.tellp() ) headerEntries.push_back( make_pair( "Functions", Output::countRegistrationCalls( output.mFunctionDef.str() ) ) );
+        for( auto entry : headerEntries ){
+            string kind = entry.first == "Declarations" || entry.first == "Definitions" ? "Header" : "HeaderPart";
+            size_t index = output.mProfileEntries.size() + headerProfileIndices.size();
+            headerProfileIndices[entry.first] = index;
+            sourceFile << "\t\t" << "{ \"" << header << "\", \"\", \"registerCinder" << name.stem().string() << entry.first << "\", RegistrationProfileEntry::" << kind << ", " << entry.second << ", {}, {} }," << endl;
+        }
+        
+        sourceFile << "\t" << "};" << endl;
+        sourceFile << "\t" << "static RegistrationProfileRegistrar sRegistrationProfileRegistrar( sRegistrationProfile, sizeof( sRegistrationProfile ) / sizeof( sRegistrationProfile[0] ) );" << endl;
+        sourceFile << endl;
+    }
+    
+    
+    // Types
+    if( output.mDeclCalls.tellp() || output.mEnumsDecl.tellp() ){
+        headerFile << "\t" << "//! registers " << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << " Forward Declarations" << endl;
+        headerFile << "\t" << "void registerCinder" << name.stem().string() << "Declarations( asIScriptEngine* engine );" << endl;
+        
+        sourceFile << "\t" << "//! registers " << name.stem().string() << " Forward Declarations" << endl;
+        sourceFile << "\t" << "void registerCinder" << name.stem().string() << "Declarations( asIScriptEngine* engine )" << endl;
+        sourceFile << "\t" << "{" << endl;
+        if( headerProfileIndices.count( "Declarations" ) ){
+            sourceFile << "\t\t" << "RegistrationProbe probe( sRegistrationProfile[" << headerProfileIndices["Declarations"] << "] );" << endl;
+        }
+        sourceFile << output.mDeclCalls.str() << endl;
+        if( output.mEnumsDecl.tellp() ){
+            sourceFile << "\t\t" << "registerCinder" << name.stem().string() << "Enums( engine );" << endl;
+        }
+        sourceFile << "\t" << "}" << endl;
+        sourceFile << endl;
+    }
+    
+    // Implemntations
+    if( output.mDefCalls.tellp() ){
+        headerFile << "\t" << "//! registers " << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << " Definitions" << endl;
+        headerFile << "\t" << "void registerCinder" << name.stem().string() << "Definitions( asIScriptEngine* engine );" << endl;
+        
+        sourceFile << "\t" << "//! registers " << name.stem().string() << " Definitions" << endl;
+        sourceFile << "\t" << "void registerCinder" << name.stem().string() << "Definitions( asIScriptEngine* engine )" << endl;
+        sourceFile << "\t" << "{" << endl;
+        if( headerProfileIndices.count( "Definitions" ) ){
+            sourceFile << "\t\t" << "RegistrationProbe probe( sRegistrationProfile[" << headerProfileIndices["Definitions"] << "] );" << endl;
+        }
+        sourceFile << output.mDefCalls.str() << endl;
+        if( output.mFunctionDef.tellp() ){
+            sourceFile << "\t\t" << "registerCinder" << name.stem().string() << "Functions( engine );" << endl;
+        }
+        sourceFile << "\t" << "}" << endl;
+        sourceFile << endl;
+    }
+    
+    if( output.mDeclCalls.tellp() || output.mDefCalls.tellp() ){
+        headerFile << endl;
+    }
+    
+    
+    // Enums
+    if( output.mEnumsDecl.tellp() ){
+        
+        headerFile << "\t" << "//! registers " << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << " Enums" << endl;
+        headerFile << "\t" << "void registerCinder" << name.stem().string() << "Enums( asIScriptEngine* engine );" << endl;
+        
+        
+        sourceFile << "\t" << "//! registers " << name.stem().string() << " Enums" << endl;
+        if( output.mEnumsExtras.tellp() ) sourceFile << endl << output.mEnumsExtras.str() << endl;
+        sourceFile << "\t" << "void registerCinder" << name.stem().string() << "Enums( asIScriptEngine* engine )" << endl;
+        sourceFile << "\t" << "{" << endl;
+        if( headerProfileIndices.count( "Enums" ) ){
+            sourceFile << "\t\t" << "RegistrationProbe probe( sRegistrationProfile[" << headerProfileIndices["Enums"] << "] );" << endl;
+        }
+        sourceFile << "\t\t" << "int r;" << endl;
+        sourceFile << endl;
+        sourceFile << output.mEnumsDecl.str() << endl;
+        sourceFile << endl;
+        sourceFile << "\t\t" << "// set back to empty default namespace " << endl;
+        sourceFile << "\t\t" << "r = engine->SetDefaultNamespace(\"\"); assert( r >= 0 );" << endl;
+        sourceFile << "\t" << "}" << endl;
+        sourceFile << endl;
+    }
+    
+    // Functions
+    if( output.mFunctionDef.tellp() ){
+        headerFile << "\t" << "//! registers " << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << " functions" << endl;
+        headerFile << "\t" << "void registerCinder" << name.stem().string() << "Functions( asIScriptEngine* engine );" << endl;
+        
+        sourceFile << "\t" << "//! registers " << name.stem().string() << " functions" << endl;
+        sourceFile << "\t" << "void registerCinder" << name.stem().string() << "Functions( asIScriptEngine* engine )" << endl;
+        sourceFile << "\t" << "{" << endl;
+        if( headerProfileIndices.count( "Functions" ) ){
+            sourceFile << "\t\t" << "RegistrationProbe probe( sRegistrationProfile[" << headerProfileIndices["Functions"] << "] );" << endl;
+        }
+        // the registrar and the commented calls don't assign the result
+        if( !output.mCurrentFunctionScope.empty() || assignsResult( output.mFunctionDef.str() ) ){
+            sourceFile << "\t\t" << "int r;" << endl;
+        }
+        if( mOptions.isRegistrarEmitterEnabled() ){
+            sourceFile << "\t\t" << "Registrar registrar( engine );" << endl;
+        }
+        sourceFile << endl;
+        sourceFile << output.mFunctionDef.str() << endl;
+        
+        // close the namespace
+        if( !output.mCurrentFunctionScope.empty() ){
+            sourceFile << endl;
+            sourceFile << "\t\t" << "// set back to empty default namespace " << endl;
+            sourceFile << "\t\t" << "r = engine->SetDefaultNamespace(\"\"); assert( r >= 0 );" << endl;
+        }
+        
+        sourceFile << "\t" << "}" << endl;
+        sourceFile << endl;
+    }
+    
+    // Header declaration
+    if( output.mClassDecl.tellp() ) headerFile << output.mClassDecl.str() << endl;
+    if( output.mClassFieldDecl.tellp() ) headerFile << output.mClassFieldDecl.str() << endl;
+    if( output.mClassMethodDecl.tellp() ) headerFile << output.mClassMethodDecl.str() << endl;
+    if( output.mTemplatesDecl.tellp() ) headerFile << output.mTemplatesDecl.str() << endl;
+    
+    // the instantiations are compiled once by the templates translation unit
+    if( !output.mTemplateInstantiations.empty() ){
+        headerFile << "\t" << "// " << name.stem().string() << " templates instantiations, defined in " << "CinderTemplates.cpp" << endl;
+        for( auto instantiation : output.mTemplateInstantiations ){
+            headerFile << "\t" << "extern " << instantiation << endl;
+        }
+        headerFile << endl;
+    }
+    
+    // Source Definitions
+    if( output.mClassExtras.tellp() ) sourceFile << output.mClassExtras.str() << endl;
+    if( output.mWrappers.tellp() ) sourceFile << output.mWrappers.str() << endl;
+    
+    // Binding tables strings, shared by every table of the file
+    if( output.mBindingStrings.size() > 1 ){
+        sourceFile << "\t" << "//! " << name.string() << " binding tables strings" << endl;
+        sourceFile << "\t" << "static const char* const sBindingStrings[] = {" << endl;
+        for( auto str : output.mBindingStrings ){
+            sourceFile << "\t\t" << "\"" << str << "\"," << endl;
+        }
+        sourceFile << "\t" << "};" << endl;
+        sourceFile << endl;
+    }
+    if( output.mClassDef.tellp() ) sourceFile << output.mClassDef.str() << endl;
+    if( output.mClassFieldDef.tellp() ) sourceFile << output.mClassFieldDef.str() << endl;
+    if( output.mClassMethodDef.tellp() ) sourceFile << output.mClassMethodDef.str() << endl;
+    
+    headerFile << endl;
+    headerFile << "}" << endl;
+    
+    sourceFile << "}" << endl;
+    
+    sink.write( record.mOutputPath + ".cpp", sourceFile.str() );
+    sink.write( record.mOutputPath + ".h", headerFile.str() );
+    
+    // the templates definitions are only included by the instantiations translation unit
+    if( output.mTemplatesDef.tellp() ){
+        stringstream inlineFile;
+        if( !mOptions.getLicense().empty() ){
+            inlineFile << mOptions.getLicense() << endl;
+            inlineFile << endl;
+        }
+        inlineFile << "namespace as {" << endl;
+        inlineFile << endl;
+        if( output.mTemplatesExtras.tellp() ) inlineFile << output.mTemplatesExtras.str() << endl;
+        inlineFile << output.mTemplatesDef.str() << endl;
+        inlineFile << "}" << endl;
+        sink.write( record.mOutputPath + ".inl", inlineFile.str() );
+    }
+}
+
+
+//! returns the headers of the current shard, balanced by size and independent of the node running it
+std::set<std::string> Parser::getShardHeaders( const std::vector<boost::filesystem::path> &inputs ) const
+{
+    // the biggest headers are dealt first, each one to the lightest shard so far
+    vector<pair<uintmax_t,string>> headers;
+    for( auto input : inputs ){
+        boost::system::error_code error;
+        uintmax_t size = fs::file_size( input, error );
+        headers.push_back( make_pair( error ? 0 : size, input.string() ) );
+    }
+    sort( headers.begin(), headers.end(), []( const pair<uintmax_t,string> &a, const pair<uintmax_t,string> &b ){
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    } );
+    
+    set<string> shardHeaders;
+    vector<uintmax_t> shardSizes( mOptions.getShardCount(), 0 );
+    for( auto header : headers ){
+        size_t shard = min_element( shardSizes.begin(), shardSizes.end() ) - shardSizes.begin();
+        shardSizes[shard] += header.first + 1;
+        if( shard == mOptions.getShardIndex() ){
+            shardHeaders.insert( header.second );
+        }
+    }
+    return shardHeaders;
+}
+
+//! writes the registry calling the registration functions of every header
+void Parser::writeRegistry( const std::string &includes, const std::string &declCalls, const std::string &defCalls, Sink &sink )
+{
+    stringstream sourceFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        sourceFile << mOptions.getLicense() << endl;
+        sourceFile << endl;
+    }
+    
+    sourceFile << "#include \"CinderBindings.h\"" << endl;
+    sourceFile << endl;
+    sourceFile << includes << endl;
+    sourceFile << "namespace as {" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "//! registers every type first so the definitions can refer to any of them" << endl;
+    sourceFile << "\t" << "void registerCinderBindings( asIScriptEngine* engine )" << endl;
+    sourceFile << "\t" << "{" << endl;
+    for( auto calls : { declCalls, defCalls } ){
+        stringstream stream( calls );
+        string line;
+        while( getline( stream, line ) ){
+            sourceFile << "\t" << line << endl;
+        }
+    }
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "}" << endl;
+    
+    stringstream headerFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        headerFile << mOptions.getLicense() << endl;
+        headerFile << endl;
+    }
+    
+    headerFile << "#pragma once" << endl;
+    headerFile << endl;
+    headerFile << "class asIScriptEngine;" << endl;
+    headerFile << endl;
+    headerFile << "namespace as {" << endl;
+    headerFile << endl;
+    headerFile << "\t" << "//! registers the declarations and the definitions of every bound header" << endl;
+    headerFile << "\t" << "void registerCinderBindings( asIScriptEngine* engine );" << endl;
+    headerFile << endl;
+    headerFile << "}" << endl;
+    
+    sink.write( "CinderBindings.cpp", sourceFile.str() );
+    sink.write( "CinderBindings.h", headerFile.str() );
+}
+
+//! collects the identifiers of the scripts and the types they reach through the headers model
+void Parser::collectUsage( const std::vector<boost::filesystem::path> &inputs )
+{
+    // tokenize the scripts, their stamps tell the next runs whether the usage is still valid
+    mUsage.mScripts     = getScriptStamps();
+    mUsage.mInputsKey   = Usage::getInputsKey( inputs );
+    for( auto script : mUsage.mScripts ){
+        std::ifstream file( script.first.c_str() );
+        std::string code((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+        Usage::tokenize( code, &mUsage.mIdentifiers );
+    }
+    
+    // the symbols of every header, only the new and changed headers are parsed again
+    map<string,HeaderSymbols> symbols;
+    map<string,std::time_t> stamps;
+    for( auto path : inputs ){
+        boost::system::error_code error;
+        fs::path canonicalPath = fs::canonical( path, error );
+        symbols[error ? path.string() : canonicalPath.string()] = getHeaderSymbols( path, stamps );
+    }
+    mCachedSymbols = symbols;
+    
+    map<string,vector<pair<string,string>>> classes;
+    map<string,string>                      templateTypedefs;
+    for( auto headerSymbols : symbols ){
+        for( auto c : headerSymbols.second.mClasses ){
+            vector<pair<string,string>> &members = classes[c.first];
+            members.insert( members.end(), c.second.begin(), c.second.end() );
+        }
+        templateTypedefs.insert( headerSymbols.second.mTemplateTypedefs.begin(), headerSymbols.second.mTemplateTypedefs.end() );
+    }
+    
+    // start from the types and functions directly referenced by the scripts
+    deque<string> reachable;
+    for( auto c : classes ){
+        if( mUsage.mIdentifiers.count( c.first ) ) reachable.push_back( c.first );
+    }
+    for( auto t : templateTypedefs ){
+        if( mUsage.mIdentifiers.count( t.first ) ) reachable.push_back( t.first );
+    }
+    for( auto headerSymbols : symbols ){
+        for( auto e : headerSymbols.second.mEnums ){
+            bool isReferenced = mUsage.mIdentifiers.count( e.first ) > 0;
+            for( auto value : e.second ){
+                isReferenced = isReferenced || mUsage.mIdentifiers.count( value );
+            }
+            if( isReferenced && !e.first.empty() ) reachable.push_back( e.first );
+        }
+        for( auto f : headerSymbols.second.mFunctions ){
+            if( mUsage.mIdentifiers.count( f.first ) ){
+                set<string> signatureTypes;
+                Usage::tokenize( f.second, &signatureTypes );
+                reachable.insert( reachable.end(), signatureTypes.begin(), signatureTypes.end() );
+            }
+        }
+    }
+    
+    // and follow the signatures of the members the scripts can reach
+    while( !reachable.empty() ){
+        string type = reachable.front();
+        reachable.pop_front();
+        
+        if( !mUsage.mTypes.insert( type ).second ){
+            continue;
+        }
+        
+        map<string,string>::iterator typedefIt = templateTypedefs.find( type );
+        if( typedefIt != templateTypedefs.end() ){
+            reachable.push_back( typedefIt->second );
+        }
+        
+        set<string> signatureTypes;
+        map<string,vector<pair<string,string>>>::iterator classIt = classes.find( type );
+        if( classIt != classes.end() ){
+            for( auto member : classIt->second ){
+                if( mUsage.isMemberReferenced( type, member.first ) ){
+                    Usage::tokenize( member.second, &signatureTypes );
+                }
+            }
+        }
+        reachable.insert( reachable.end(), signatureTypes.begin(), signatureTypes.end() );
+    }
+    
+    mUsage.mEnabled = true;
+    
+    size_t numUsedClasses = 0;
+    for( auto c : classes ){
+        if( mUsage.mTypes.count( c.first ) ) numUsedClasses++;
+    }
+    cout << "Scripts reach " << numUsedClasses << " of " << classes.size() << " classes" << endl;
+}
+
+//! returns the symbols of a header, from the previous runs if none of the files it read changed
+Parser::HeaderSymbols Parser::getHeaderSymbols( const boost::filesystem::path &path, std::map<std::string,std::time_t> &stamps )
+{
+    // the headers share most of their includes so every file is only checked once
+    auto getStamp = [&stamps]( const string &file ){
+        auto stamp = stamps.find( file );
+        if( stamp == stamps.end() ){
+            boost::system::error_code error;
+            std::time_t time = fs::last_write_time( file, error );
+            stamp = stamps.insert( make_pair( file, error ? std::time_t( -1 ) : time ) ).first;
+        }
+        return stamp->second;
+    };
+    
+    boost::system::error_code error;
+    fs::path canonicalPath = fs::canonical( path, error );
+    string header = error ? path.string() : canonicalPath.string();
+    auto cachedSymbols = mCachedSymbols.find( header );
+    if( cachedSymbols != mCachedSymbols.end() ){
+        bool isValid = true;
+        for( auto file : cachedSymbols->second.mFiles ){
+            isValid = isValid && getStamp( file.first ) == file.second;
+        }
+        if( isValid ){
+            return cachedSymbols->second;
+        }
+    }
+    
+    HeaderSymbols symbols;
+    symbols.mFiles[header] = getStamp( header );
+    
+    std::ifstream file( path.c_str() );
+    std::string code((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    if( mOptions.isPrefilterEnabled() && !hasDeclarations( code ) ){
+        return symbols;
+    }
+    
+    // mUsage is still disabled so nothing is filtered
+    Output output;
+    runTool( new FrontendAction( output, mOptions, mUsage ), code, path.filename().string() );
+    
+    for( auto include : output.mIncludes ){
+        if( !include.mPath.empty() ){
+            boost::system::error_code includeError;
+            fs::path included = fs::canonical( include.mPath, includeError );
+            string includedPath = includeError ? include.mPath : included.string();
+            symbols.mFiles[includedPath] = getStamp( includedPath );
+        }
+    }
+    for( auto c : output.mClasses ){
+        vector<pair<string,string>> &members = symbols.mClasses[c->getName()];
+        for( auto method : c->getMethods() ){
+            members.push_back( make_pair( method.getName(), method.getReturnType() + " " + method.getParamsTypesNames() ) );
+        }
+        for( auto field : c->getFields() ){
+            members.push_back( make_pair( field.getName(), field.getType() ) );
+        }
+    }
+    symbols.mTemplateTypedefs = output.mTemplateTypedefs;
+    for( auto e : output.mEnums ){
+        symbols.mEnums.push_back( make_pair( e->getName(), e->getValues() ) );
+    }
+    for( auto f : output.mFunctions ){
+        symbols.mFunctions.push_back( make_pair( f->getName(), f->getReturnType() + " " + f->getParamsTypesNames() ) );
+    }
+    return symbols;
+}
+
+//! returns the modification time of every script of the script directory
+std::map<std::string,std::time_t> Parser::getScriptStamps() const
+{
+    map<string,std::time_t> stamps;
+    if( mOptions.getScriptDirectory().empty() ){
+        return stamps;
+    }
+    
+    boost::system::error_code error;
+    fs::recursive_directory_iterator dir( mOptions.getScriptDirectory(), error ), end;
+    while( !error && dir != end ){
+        const fs::path& current = dir->path();
+        if( !fs::is_directory( current ) && current.extension() == ".as" ){
+            stamps[current.string()] = fs::last_write_time( current, error );
+        }
+        dir.increment( error );
+    }
+    return stamps;
+}
+
+//! returns a key identifying the headers the types are collected from
+std::string Parser::Usage::getInputsKey( const std::vector<boost::filesystem::path> &inputs )
+{
+    vector<string> paths;
+    for( auto path : inputs ){
+        paths.push_back( path.string() );
+    }
+    sort( paths.begin(), paths.end() );
+    return to_string( std::hash<std::string>()( boost::algorithm::join( paths, "\n" ) ) );
+}
+
+//! adds the identifiers of a script or a declaration, skipping comments, strings and numbers
+void Parser::Usage::tokenize( const std::string &code, std::set<std::string> *identifiers )
+{
+    size_t length = code.length();
+    size_t i = 0;
+    while( i < length ){
+        char c = code[i];
+        
+        // comments
+        if( c == '/' && i + 1 < length && code[i+1] == '/' ){
+            i = code.find( '\n', i );
+            if( i == string::npos ) break;
+        }
+        else if( c == '/' && i + 1 < length && code[i+1] == '*' ){
+            i = code.find( "*/", i + 2 );
+            if( i == string::npos ) break;
+            i += 2;
+        }
+        // heredoc and regular strings
+        else if( code.compare( i, 3, "\"\"\"" ) == 0 ){
+            i = code.find( "\"\"\"", i + 3 );
+            if( i == string::npos ) break;
+            i += 3;
+        }
+        else if( c == '"' || c == '\'' ){
+            for( i++; i < length && code[i] != c; i++ ){
+                if( code[i] == '\\' ) i++;
+            }
+            i++;
+        }
+        // identifiers
+        else if( std::isalpha( static_cast<unsigned char>( c ) ) || c == '_' ){
+            size_t start = i;
+            while( i < length && ( std::isalnum( static_cast<unsigned char>( code[i] ) ) || code[i] == '_' ) ) i++;
+            identifiers->insert( code.substr( start, i - start ) );
+        }
+        // numbers, including suffixes and exponents
+        else if( std::isdigit( static_cast<unsigned char>( c ) ) ){
+            while( i < length && ( std::isalnum( static_cast<unsigned char>( code[i] ) ) || code[i] == '_' || code[i] == '.' ) ) i++;
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+//! writes the registration units table and its dependencies
+void Parser::writeRegistrationUnits( Sink &sink )
+{
+    // map the dependencies paths to units
+    map<string,int> unitsIndices;
+    for( size_t i = 0; i < mUnits.size(); i++ ){
+        unitsIndices[mUnits[i].mPath] = i;
+    }
+    
+    stringstream sourceFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        sourceFile << mOptions.getLicense() << endl;
+        sourceFile << endl;
+    }
+    
+    sourceFile << "#include \"CinderRegistrationUnits.h\"" << endl;
+    sourceFile << endl;
+    for( auto unit : mUnits ){
+        sourceFile << "#include \"" << fs::path( unit.mHeader ).replace_extension( ".h" ).string() << "\"" << endl;
+    }
+    sourceFile << endl;
+    sourceFile << "namespace as {" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "namespace {" << endl;
+    
+    // dependencies and types lists
+    for( size_t i = 0; i < mUnits.size(); i++ ){
+        const Unit &unit = mUnits[i];
+        
+        sourceFile << endl;
+        sourceFile << "\t\t" << "// cinder/" << unit.mHeader << endl;
+        sourceFile << "\t\t" << "const int sUnit" << i << "Dependencies[] = { ";
+        for( auto dependency : unit.mDependencies ){
+            map<string,int>::iterator it = unitsIndices.find( dependency );
+            if( it != unitsIndices.end() && it->second != static_cast<int>( i ) ){
+                sourceFile << it->second << ", ";
+            }
+        }
+        sourceFile << "-1 };" << endl;
+        sourceFile << "\t\t" << "const char* const sUnit" << i << "Types[] = { ";
+        for( auto type : unit.mTypes ){
+            sourceFile << "\"" << type << "\", ";
+        }
+        sourceFile << "nullptr };" << endl;
+    }
+    
+    // units table
+    sourceFile << endl;
+    sourceFile << "\t\t" << "const RegistrationUnit sUnits[] = {" << endl;
+    for( size_t i = 0; i < mUnits.size(); i++ ){
+        const Unit &unit = mUnits[i];
+        sourceFile << "\t\t\t" << "{ \"" << unit.mName << "\", \"cinder/" << unit.mHeader << "\", ";
+        sourceFile << ( unit.mHasDeclarations ? "registerCinder" + unit.mName + "Declarations" : "nullptr" ) << ", ";
+        sourceFile << ( unit.mHasDefinitions ? "registerCinder" + unit.mName + "Definitions" : "nullptr" ) << ", ";
+        sourceFile << "sUnit" << i << "Dependencies, sUnit" << i << "Types }," << endl;
+    }
+    sourceFile << "\t\t" << "};" << endl;
+    sourceFile << "\t\t" << "const size_t sNumUnits = " << mUnits.size() << ";" << endl;
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    
+    sourceFile << "\t" << "const RegistrationUnit* getCinderRegistrationUnits( size_t *count )" << endl;
+    sourceFile << "\t" << "{" << endl;
+    sourceFile << "\t\t" << "*count = sNumUnits;" << endl;
+    sourceFile << "\t\t" << "return sUnits;" << endl;
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "void registerCinderUnits( asIScriptEngine* engine, const std::vector<std::string> &units )" << endl;
+    sourceFile << "\t" << "{" << endl;
+    sourceFile << "\t\t" << "std::vector<int> roots;" << endl;
+    sourceFile << "\t\t" << "for( auto unit : units ){" << endl;
+    sourceFile << "\t\t\t" << "roots.push_back( findRegistrationUnit( sUnits, sNumUnits, unit ) );" << endl;
+    sourceFile << "\t\t" << "}" << endl;
+    sourceFile << "\t\t" << "registerRegistrationUnits( engine, sUnits, sNumUnits, roots );" << endl;
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "void registerCinderTypes( asIScriptEngine* engine, const std::vector<std::string> &typeNames )" << endl;
+    sourceFile << "\t" << "{" << endl;
+    sourceFile << "\t\t" << "std::vector<int> roots;" << endl;
+    sourceFile << "\t\t" << "for( auto type : typeNames ){" << endl;
+    sourceFile << "\t\t\t" << "roots.push_back( findRegistrationUnitForType( sUnits, sNumUnits, type ) );" << endl;
+    sourceFile << "\t\t" << "}" << endl;
+    sourceFile << "\t\t" << "registerRegistrationUnits( engine, sUnits, sNumUnits, roots );" << endl;
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "}" << endl;
+    
+    stringstream headerFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        headerFile << mOptions.getLicense() << endl;
+        headerFile << endl;
+    }
+    
+    headerFile << "#pragma once" << endl;
+    headerFile << endl;
+    headerFile << "#include \"RegistrationUnits.h\"" << endl;
+    headerFile << endl;
+    headerFile << "namespace as {" << endl;
+    headerFile << endl;
+    headerFile << "\t" << "//! returns the table of cinder registration units" << endl;
+    headerFile << "\t" << "const RegistrationUnit* getCinderRegistrationUnits( size_t *count );" << endl;
+    headerFile << "\t" << "//! registers the units, by name or header, and the closure of their dependencies" << endl;
+    headerFile << "\t" << "void registerCinderUnits( asIScriptEngine* engine, const std::vector<std::string> &units );" << endl;
+    headerFile << "\t" << "//! registers the units declaring the script types and the closure of their dependencies" << endl;
+    headerFile << "\t" << "void registerCinderTypes( asIScriptEngine* engine, const std::vector<std::string> &typeNames );" << endl;
+    headerFile << endl;
+    headerFile << "}" << endl;
+    
+    sink.write( "CinderRegistrationUnits.cpp", sourceFile.str() );
+    sink.write( "CinderRegistrationUnits.h", headerFile.str() );
+}
+
+//! writes the counters array and the names of the counted bindings
+void Parser::writeBindingCounters( Sink &sink )
+{
+    stringstream sourceFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        sourceFile << mOptions.getLicense() << endl;
+        sourceFile << endl;
+    }
+    
+    // the array is never empty so the declaration stays valid without any counted binding
+    size_t numBindings = std::max<size_t>( mCountedBindings.size(), 1 );
+    
+    sourceFile << "#include \"CinderBindingCounters.h\"" << endl;
+    sourceFile << endl;
+    sourceFile << "namespace as {" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "std::atomic<uint64_t> sBindingCallCounts[" << numBindings << "];" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "namespace {" << endl;
+    sourceFile << "\t\t" << "const char* const sBindingNames[] = {" << endl;
+    for( auto name : mCountedBindings ){
+        sourceFile << "\t\t\t" << "\"" << name << "\"," << endl;
+    }
+    if( mCountedBindings.empty() ){
+        sourceFile << "\t\t\t" << "\"\"," << endl;
+    }
+    sourceFile << "\t\t" << "};" << endl;
+    sourceFile << "\t\t" << "const size_t sNumBindings = " << mCountedBindings.size() << ";" << endl;
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "std::vector<std::pair<std::string,uint64_t>> getCinderBindingCallCounts()" << endl;
+    sourceFile << "\t" << "{" << endl;
+    sourceFile << "\t\t" << "return getBindingCallCounts( sBindingNames, sNumBindings );" << endl;
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "void dumpCinderBindingCallCounts( std::ostream &stream )" << endl;
+    sourceFile << "\t" << "{" << endl;
+    sourceFile << "\t\t" << "dumpBindingCallCounts( stream, sBindingNames, sNumBindings );" << endl;
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "void resetCinderBindingCallCounts()" << endl;
+    sourceFile << "\t" << "{" << endl;
+    sourceFile << "\t\t" << "resetBindingCallCounts( sNumBindings );" << endl;
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "}" << endl;
+    
+    stringstream headerFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        headerFile << mOptions.getLicense() << endl;
+        headerFile << endl;
+    }
+    
+    headerFile << "#pragma once" << endl;
+    headerFile << endl;
+    headerFile << "#include \"BindingCounters.h\"" << endl;
+    headerFile << endl;
+    headerFile << "namespace as {" << endl;
+    headerFile << endl;
+    
+    // the bindings of a header count their calls from its base, the headers only have to be compiled again when it moves
+    size_t bindingIdBase = 0;
+    for( auto record : mRecords ){
+        if( !record.mCountedBindings.empty() ){
+            headerFile << "\t" << "constexpr size_t " << getBindingIdBase( record.mName ) << " = " << bindingIdBase << ";" << endl;
+        }
+        bindingIdBase += record.mCountedBindings.size();
+    }
+    if( bindingIdBase ){
+        headerFile << endl;
+    }
+    
+    headerFile << "\t" << "//! returns the qualified name and call count of the called bindings, most called first" << endl;
+    headerFile << "\t" << "std::vector<std::pair<std::string,uint64_t>> getCinderBindingCallCounts();" << endl;
+    headerFile << "\t" << "//! writes the call count and qualified name of the called bindings, most called first" << endl;
+    headerFile << "\t" << "void dumpCinderBindingCallCounts( std::ostream &stream );" << endl;
+    headerFile << "\t" << "//! sets every call count back to zero" << endl;
+    headerFile << "\t" << "void resetCinderBindingCallCounts();" << endl;
+    headerFile << endl;
+    headerFile << "}" << endl;
+    
+    sink.write( "CinderBindingCounters.cpp", sourceFile.str() );
+    sink.write( "CinderBindingCounters.h", headerFile.str() );
+}
+
+//! returns the constant the ids of the counted bindings of a header are offset by
+std::string Parser::getBindingIdBase( const std::string &name )
+{
+    return "sCinder" + name + "BindingIdBase";
+}
+
+//! writes the translation unit instantiating every template registration function
+void Parser::writeTemplateInstantiations( Sink &sink )
+{
+    stringstream sourceFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        sourceFile << mOptions.getLicense() << endl;
+        sourceFile << endl;
+    }
+    
+    sourceFile << "// Avoid having to inform include path if header is already include before" << endl;
+    sourceFile << "#ifndef ANGELSCRIPT_H" << endl;
+    sourceFile << "\t" << "#include <angelscript.h>" << endl;
+    sourceFile << "#endif" << endl;
+    sourceFile << endl;
+    sourceFile << "#include \"RegistrationHelper.h\"" << endl;
+    if( mOptions.isThreadSafeFactoriesEnabled() || mOptions.isPooledFactoriesEnabled() ){
+        sourceFile << "#include \"RefCounted.h\"" << endl;
+    }
+    if( mOptions.isPooledFactoriesEnabled() ){
+        sourceFile << "#include \"FactoryPool.h\"" << endl;
+    }
+    if( mOptions.isCallCountersEnabled() ){
+        sourceFile << "#include \"CinderBindingCounters.h\"" << endl;
+    }
+    for( auto header : mTemplatesHeaders ){
+        sourceFile << "#include \"" << header << "\"" << endl;
+    }
+    sourceFile << endl;
+    sourceFile << "using namespace std;" << endl;
+    sourceFile << "using namespace ci;" << endl;
+    sourceFile << endl;
+    for( auto inlineFile : mTemplatesInlines ){
+        sourceFile << "#include \"" << inlineFile << "\"" << endl;
+    }
+    sourceFile << endl;
+    sourceFile << "namespace as {" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "// templates instantiations so the generated headers can declare them extern" << endl;
+    for( auto instantiation : mTemplateInstantiations ){
+        sourceFile << "\t" << instantiation << endl;
+    }
+    sourceFile << endl;
+    sourceFile << "}" << endl;
+    
+    sink.write( "CinderTemplates.cpp", sourceFile.str() );
+}
+
+//! writes the registration of the vector views used by the bindings
+void Parser::writeVectorViews( Sink &sink )
+{
+    stringstream sourceFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        sourceFile << mOptions.getLicense() << endl;
+        sourceFile << endl;
+    }
+    
+    sourceFile << "#include \"CinderVectorViews.h\"" << endl;
+    sourceFile << endl;
+    sourceFile << "// Avoid having to inform include path if header is already include before" << endl;
+    sourceFile << "#ifndef ANGELSCRIPT_H" << endl;
+    sourceFile << "\t" << "#include <angelscript.h>" << endl;
+    sourceFile << "#endif" << endl;
+    sourceFile << endl;
+    sourceFile << "#include \"VectorView.h\"" << endl;
+    for( auto header : mVectorViewsHeaders ){
+        sourceFile << "#include \"" << header << "\"" << endl;
+    }
+    sourceFile << endl;
+    sourceFile << "using namespace std;" << endl;
+    sourceFile << "using namespace ci;" << endl;
+    sourceFile << endl;
+    sourceFile << "namespace as {" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "//! registers the vector views types" << endl;
+    sourceFile << "\t" << "void registerCinderVectorViewsDeclarations( asIScriptEngine* engine )" << endl;
+    sourceFile << "\t" << "{" << endl;
+    for( auto view : mVectorViews ){
+        sourceFile << "\t\t" << "registerVectorViewType( engine, \"" << view.first << "\" );" << endl;
+    }
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "\t" << "//! registers the vector views methods" << endl;
+    sourceFile << "\t" << "void registerCinderVectorViewsDefinitions( asIScriptEngine* engine )" << endl;
+    sourceFile << "\t" << "{" << endl;
+    for( auto view : mVectorViews ){
+        sourceFile << "\t\t" << "registerVectorViewMethods<" << view.second.first << " >( engine, \"" << view.first << "\", \"" << view.second.second << "\" );" << endl;
+    }
+    sourceFile << "\t" << "}" << endl;
+    sourceFile << endl;
+    sourceFile << "}" << endl;
+    
+    stringstream headerFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        headerFile << mOptions.getLicense() << endl;
+        headerFile << endl;
+    }
+    
+    headerFile << "#pragma once" << endl;
+    headerFile << endl;
+    headerFile << "class asIScriptEngine;" << endl;
+    headerFile << endl;
+    headerFile << "namespace as {" << endl;
+    headerFile << endl;
+    headerFile << "\t" << "//! registers the script types viewing the std::vector used by the bindings" << endl;
+    headerFile << "\t" << "void registerCinderVectorViewsDeclarations( asIScriptEngine* engine );" << endl;
+    headerFile << "\t" << "//! registers the methods of the vector views, after the declarations of their elements" << endl;
+    headerFile << "\t" << "void registerCinderVectorViewsDefinitions( asIScriptEngine* engine );" << endl;
+    headerFile << endl;
+    headerFile << "}" << endl;
+    
+    sink.write( "CinderVectorViews.cpp", sourceFile.str() );
+    sink.write( "CinderVectorViews.h", headerFile.str() );
+}
+
+//! writes the macros telling the factories which types only they create
+void Parser::writeFactoryTypes( Sink &sink )
+{
+    stringstream headerFile;
+    
+    if( !mOptions.getLicense().empty() ){
+        headerFile << mOptions.getLicense() << endl;
+        headerFile << endl;
+    }
+    
+    headerFile << "#pragma once" << endl;
+    headerFile << endl;
+    headerFile << "// the types the scripts only get from their factory keep their reference count with the object," << endl;
+    headerFile << "// the types returned by reference or pointer or exposed as properties keep it in a map" << endl;
+    for( auto type : mFactoryTypes ){
+        if( !mEscapingTypes.count( type ) ){
+            headerFile << "#define CINDER_FACTORY_ONLY_" << type << endl;
+        }
+    }
+    
+    sink.write( "CinderFactoryTypes.h", headerFile.str() );
+}
+
+//! adds what a header contributes to the shared files and to the global registration calls
+void Parser::addHeaderRecord( const HeaderRecord &record, std::stringstream &globalIncludes, std::stringstream &globalDeclCalls, std::stringstream &globalDefCalls )
+{
+    globalIncludes << "#include \"" << record.mName << ".h\"" << endl;
+    if( record.mHasDeclarations ){
+        globalDeclCalls << "\t" << "as::registerCinder" << record.mName << "Declarations( engine );" << endl;
+    }
+    if( record.mHasDefinitions ){
+        globalDefCalls << "\t" << "as::registerCinder" << record.mName << "Definitions( engine );" << endl;
+    }
+    
+    // keep track of the registration functions of the header
+    if( record.mHasDeclarations || record.mHasDefinitions ){
+        Unit unit;
+        unit.mName              = record.mName;
+        unit.mHeader            = record.mHeader;
+        unit.mPath              = record.mPath;
+        unit.mHasDeclarations   = record.mHasDeclarations;
+        unit.mHasDefinitions    = record.mHasDefinitions;
+        unit.mTypes             = record.mTypes;
+        unit.mDependencies      = record.mDependencies;
+        mUnits.push_back( unit );
+    }
+    
+    // the next header counted bindings start after this one
+    mCountedBindings.insert( mCountedBindings.end(), record.mCountedBindings.begin(), record.mCountedBindings.end() );
+    
+    // the templates are instantiated once for every header
+    if( record.mHasTemplates ){
+        mTemplatesHeaders.push_back( "cinder/" + record.mHeader );
+        mTemplatesHeaders.push_back( record.mOutputPath + ".h" );
+        mTemplatesInlines.push_back( record.mOutputPath + ".inl" );
+    }
+    mTemplateInstantiations.insert( record.mTemplateInstantiations.begin(), record.mTemplateInstantiations.end() );
+    
+    // the views are shared by every header so they are registered once
+    if( !record.mVectorViews.empty() ){
+        mVectorViews.insert( record.mVectorViews.begin(), record.mVectorViews.end() );
+        mVectorViewsHeaders.insert( "cinder/" + record.mHeader );
+    }
+    
+    // a type keeps its count in a map if any header hands it to the scripts without its factory
+    mFactoryTypes.insert( record.mFactoryTypes.begin(), record.mFactoryTypes.end() );
+    mEscapingTypes.insert( record.mEscapingTypes.begin(), record.mEscapingTypes.end() );
+    
+    mRecords.push_back( record );
+}
+
+//! returns a string identifying the options changing the generated files
+std::string Parser::getOptionsKey() const
+{
+    stringstream key;
+    key << mOptions.isTableRegistrationEnabled() << mOptions.isRegistrationUnitsEnabled() << mOptions.isThreadSafeFactoriesEnabled() << mOptions.isPooledFactoriesEnabled();
+    key << mOptions.isThreadLocalPoolsEnabled() << mOptions.isRegistrationProfilingEnabled() << mOptions.isCallCountersEnabled() << mOptions.isAccessorPropertiesEnabled();
+    key << mOptions.isVectorViewsEnabled() << mOptions.isStringWrappersEnabled() << mOptions.isRegistrarEmitterEnabled();
+    key << " " << mOptions.getScriptDirectory() << " " << std::hash<std::string>()( mOptions.getLicense() );
+    for( auto flag : mOptions.getCompilerFlags() ){
+        key << " " << flag;
+    }
+    for( auto type : mOptions.getUnsupportedTypes() ){
+        key << " " << type;
+    }
+    string result = key.str();
+    boost::replace_all( result, "\t", " " );
+    boost::replace_all( result, "\n", " " );
+    return result;
+}
+
+//! reads an include graph and its headers records, written by a previous run or by a shard
+void Parser::readIncludeGraph( const std::string &path )
+{
+    ifstream graphFile( path );
+    if( !graphFile ){
+        return;
+    }
+    
+    // the records are only kept once the whole file is read
+    map<string,HeaderRecord> records;
+    map<string,HeaderSymbols> symbols;
+    map<string,std::time_t> stamps;
+    Usage usage;
+    
+    string line;
+    HeaderRecord* record = nullptr;
+    HeaderSymbols* headerSymbols = nullptr;
+    while( getline( graphFile, line ) ){
+        vector<string> fields;
+        boost::split( fields, line, boost::is_any_of( "\t" ) );
+        const string &kind = fields[0];
+        
+        // a graph written with other options describes other generated files
+        if( kind == "options" ){
+            if( fields.size() < 2 || fields[1] != getOptionsKey() ){
+                return;
+            }
+        }
+        else if( kind == "file" && fields.size() == 3 ){
+            stamps[fields[1]] = static_cast<std::time_t>( stoll( fields[2] ) );
+        }
+        else if( kind == "script" && fields.size() == 3 ){
+            usage.mScripts[fields[1]] = static_cast<std::time_t>( stoll( fields[2] ) );
+        }
+        else if( kind == "usage" && fields.size() == 2 ){
+            usage.mEnabled      = true;
+            usage.mInputsKey    = fields[1];
+        }
+        else if( kind == "identifier" && fields.size() == 2 ){
+            usage.mIdentifiers.insert( fields[1] );
+        }
+        else if( kind == "used" && fields.size() == 2 ){
+            usage.mTypes.insert( fields[1] );
+        }
+        else if( boost::starts_with( kind, "symbol" ) ){
+            headerSymbols = readHeaderSymbolsLine( fields, symbols, headerSymbols );
+        }
+        else {
+            record = readHeaderRecordLine( fields, records, record );
+        }
+    }
+    
+    // the symbols carry their own stamps and don't depend on the scripts
+    for( auto cachedSymbols : symbols ){
+        mCachedSymbols[cachedSymbols.first] = cachedSymbols.second;
+    }
+    
+    // every header depends on the scripts, a changed, added or removed script invalidates them all
+    if( usage.mScripts != getScriptStamps() ){
+        return;
+    }
+    if( usage.mEnabled ){
+        mCachedUsage = usage;
+    }
+    
+    for( auto cachedRecord : records ){
+        mCachedRecords[cachedRecord.first] = cachedRecord.second;
+    }
+    for( auto stamp : stamps ){
+        mFileStamps[stamp.first] = stamp.second;
+    }
+}
+
+//! writes a header record, one line per field with its kind first, the record starts with its header line
+void Parser::writeHeaderRecord( std::ostream &stream, const HeaderRecord &record )
+{
+    stream << "header" << "\t" << record.mPath << "\t" << record.mName << "\t" << record.mHeader << "\t" << record.mOutputPath << "\t";
+    stream << record.mHasDeclarations << "\t" << record.mHasDefinitions << "\t" << record.mHasTemplates << endl;
+    for( auto edge : record.mIncludes ){
+        stream << "include" << "\t" << edge.mIncluder << "\t" << edge.mIncluded << "\t" << edge.mPath << endl;
+    }
+    for( auto type : record.mTypes ){
+        stream << "type" << "\t" << type << endl;
+    }
+    for( auto dependency : record.mDependencies ){
+        stream << "dependency" << "\t" << dependency << endl;
+    }
+    for( auto binding : record.mCountedBindings ){
+        stream << "binding" << "\t" << binding << endl;
+    }
+    for( auto view : record.mVectorViews ){
+        stream << "view" << "\t" << view.first << "\t" << view.second.first << "\t" << view.second.second << endl;
+    }
+    for( auto instantiation : record.mTemplateInstantiations ){
+        stream << "instantiation" << "\t" << instantiation << endl;
+    }
+    for( auto type : record.mFactoryTypes ){
+        stream << "factory" << "\t" << type << endl;
+    }
+    for( auto type : record.mEscapingTypes ){
+        stream << "escape" << "\t" << type << endl;
+    }
+    stream << "timing" << "\t" << record.mParseTime << "\t" << record.mVisitTime << "\t" << record.mEmitTime << endl;
+    
+    const HeaderMemory &memory = record.mMemory;
+    if( memory.mRssAfter ){
+        stream << "memory" << "\t" << memory.mRssBefore << "\t" << memory.mRssAfter << "\t" << memory.mAstBytes << "\t" << memory.mSideTableBytes << "\t";
+        stream << memory.mSourceMallocBytes << "\t" << memory.mSourceMmapBytes << "\t" << memory.mSourceTableBytes << "\t" << memory.mOutputBytes << endl;
+        for( auto section : memory.mSections ){
+            stream << "section" << "\t" << section.first << "\t" << section.second << endl;
+        }
+    }
+}
+
+//! reads a line of a header record and returns the record the next lines belong to
+Parser::HeaderRecord* Parser::readHeaderRecordLine( const std::vector<std::string> &fields, std::map<std::string,HeaderRecord> &records, HeaderRecord* record )
+{
+    const string &kind = fields[0];
+    if( kind == "header" && fields.size() == 8 ){
+        record = &records[fields[1]];
+        *record                     = HeaderRecord();
+        record->mPath               = fields[1];
+        record->mName               = fields[2];
+        record->mHeader             = fields[3];
+        record->mOutputPath         = fields[4];
+        record->mHasDeclarations    = fields[5] == "1";
+        record->mHasDefinitions     = fields[6] == "1";
+        record->mHasTemplates       = fields[7] == "1";
+    }
+    else if( !record ){
+        return nullptr;
+    }
+    else if( kind == "include" && fields.size() == 4 ){
+        IncludeEdge edge;
+        edge.mIncluder  = fields[1];
+        edge.mIncluded  = fields[2];
+        edge.mPath      = fields[3];
+        record->mIncludes.push_back( edge );
+    }
+    else if( kind == "type" && fields.size() == 2 ){
+        record->mTypes.push_back( fields[1] );
+    }
+    else if( kind == "dependency" && fields.size() == 2 ){
+        record->mDependencies.insert( fields[1] );
+    }
+    else if( kind == "binding" && fields.size() == 2 ){
+        record->mCountedBindings.push_back( fields[1] );
+    }
+    else if( kind == "view" && fields.size() == 4 ){
+        record->mVectorViews[fields[1]] = make_pair( fields[2], fields[3] );
+    }
+    else if( kind == "instantiation" && fields.size() == 2 ){
+        record->mTemplateInstantiations.insert( fields[1] );
+    }
+    else if( kind == "factory" && fields.size() == 2 ){
+        record->mFactoryTypes.insert( fields[1] );
+    }
+    else if( kind == "escape" && fields.size() == 2 ){
+        record->mEscapingTypes.insert( fields[1] );
+    }
+    else if( kind == "memory" && fields.size() == 9 ){
+        HeaderMemory &memory        = record->mMemory;
+        memory.mRssBefore           = stoull( fields[1] );
+        memory.mRssAfter            = stoull( fields[2] );
+        memory.mAstBytes            = stoull( fields[3] );
+        memory.mSideTableBytes      = stoull( fields[4] );
+        memory.mSourceMallocBytes   = stoull( fields[5] );
+        memory.mSourceMmapBytes     = stoull( fields[6] );
+        memory.mSourceTableBytes    = stoull( fields[7] );
+        memory.mOutputBytes         = stoull( fields[8] );
+    }
+    else if( kind == "section" && fields.size() == 3 ){
+        record->mMemory.mSections[fields[1]] = stoull( fields[2] );
+    }
+    else if( kind == "timing" && fields.size() == 4 ){
+        record->mParseTime  = stod( fields[1] );
+        record->mVisitTime  = stod( fields[2] );
+        record->mEmitTime   = stod( fields[3] );
+    }
+    return record;
+}
+
+//! writes the symbols of a header, they start with their symbols line and use the same format as the records
+void Parser::writeHeaderSymbols( std::ostream &stream, const std::string &path, const HeaderSymbols &symbols )
+{
+    stream << "symbols" << "\t" << path << endl;
+    for( auto file : symbols.mFiles ){
+        stream << "symbolfile" << "\t" << file.first << "\t" << static_cast<long long>( file.second ) << endl;
+    }
+    for( auto c : symbols.mClasses ){
+        stream << "symbolclass" << "\t" << c.first << endl;
+        for( auto member : c.second ){
+            stream << "symbolmember" << "\t" << c.first << "\t" << member.first << "\t" << member.second << endl;
+        }
+    }
+    for( auto t : symbols.mTemplateTypedefs ){
+        stream << "symboltypedef" << "\t" << t.first << "\t" << t.second << endl;
+    }
+    for( auto e : symbols.mEnums ){
+        stream << "symbolenum" << "\t" << e.first << endl;
+        for( auto value : e.second ){
+            stream << "symbolvalue" << "\t" << value << endl;
+        }
+    }
+    for( auto f : symbols.mFunctions ){
+        stream << "symbolfunction" << "\t" << f.first << "\t" << f.second << endl;
+    }
+}
+
+//! reads a line of the symbols of a header and returns the symbols the next lines belong to
+Parser::HeaderSymbols* Parser::readHeaderSymbolsLine( const std::vector<std::string> &fields, std::map<std::string,HeaderSymbols> &symbols, HeaderSymbols* headerSymbols )
+{
+    const string &kind = fields[0];
+    if( kind == "symbols" && fields.size() == 2 ){
+        headerSymbols   = &symbols[fields[1]];
+        *headerSymbols  = HeaderSymbols();
+    }
+    else if( !headerSymbols ){
+        return nullptr;
+    }
+    else if( kind == "symbolfile" && fields.size() == 3 ){
+        headerSymbols->mFiles[fields[1]] = static_cast<std::time_t>( stoll( fields[2] ) );
+    }
+    else if( kind == "symbolclass" && fields.size() == 2 ){
+        headerSymbols->mClasses[fields[1]];
+    }
+    else if( kind == "symbolmember" && fields.size() == 4 ){
+        headerSymbols->mClasses[fields[1]].push_back( make_pair( fields[2], fields[3] ) );
+    }
+    else if( kind == "symboltypedef" && fields.size() == 3 ){
+        headerSymbols->mTemplateTypedefs[fields[1]] = fields[2];
+    }
+    else if( kind == "symbolenum" && fields.size() == 2 ){
+        headerSymbols->mEnums.push_back( make_pair( fields[1], vector<string>() ) );
+    }
+    // the values belong to the last enum, anonymous enums don't have a name to refer to them
+    else if( kind == "symbolvalue" && fields.size() == 2 && !headerSymbols->mEnums.empty() ){
+        headerSymbols->mEnums.back().second.push_back( fields[1] );
+    }
+    else if( kind == "symbolfunction" && fields.size() == 3 ){
+        headerSymbols->mFunctions.push_back( make_pair( fields[1], fields[2] ) );
+    }
+    return headerSymbols;
+}
+
+//! reads the parse, visit and emit times of the headers recorded by the previous runs
+void Parser::readTimings()
+{
+    ifstream timingsFile( mOptions.getOutputDirectory() + "/CinderTimings.txt" );
+    string line;
+    while( getline( timingsFile, line ) ){
+        vector<string> fields;
+        boost::split( fields, line, boost::is_any_of( "\t" ) );
+        if( fields.size() == 5 ){
+            HeaderTiming &timing    = mTimings[fields[0]];
+            timing.mSize            = stoull( fields[1] );
+            timing.mParseTime       = stod( fields[2] );
+            timing.mVisitTime       = stod( fields[3] );
+            timing.mEmitTime        = stod( fields[4] );
+        }
+    }
+}
+
+//! adds the times of the headers parsed by this run to the history and writes it
+void Parser::writeTimings( Sink &sink )
+{
+    readTimings();
+    for( auto record : mRecords ){
+        // the reused headers keep the times of the run that parsed them
+        if( record.mParseTime <= 0 ){
+            continue;
+        }
+        boost::system::error_code error;
+        HeaderTiming &timing    = mTimings[record.mPath];
+        timing.mSize            = fs::file_size( record.mPath, error );
+        timing.mParseTime       = record.mParseTime;
+        timing.mVisitTime       = record.mVisitTime;
+        timing.mEmitTime        = record.mEmitTime;
+    }
+    
+    stringstream timingsFile;
+    for( auto timing : mTimings ){
+        timingsFile << timing.first << "\t" << timing.second.mSize << "\t" << timing.second.mParseTime << "\t" << timing.second.mVisitTime << "\t" << timing.second.mEmitTime << endl;
+    }
+    sink.write( "CinderTimings.txt", timingsFile.str() );
+}
+
+//! returns the mean cost per byte of the recorded headers
+double Parser::getCostPerByte() const
+{
+    double cost = 0.0, size = 0.0;
+    for( const auto &timing : mTimings ){
+        cost += timing.second.mParseTime + timing.second.mVisitTime + timing.second.mEmitTime;
+        size += timing.second.mSize;
+    }
+    return size > 0 ? cost / size : 1.0;
+}
+
+//! returns the recorded cost of a header, or an estimate from its size and the cost per byte of the recorded headers
+double Parser::getEstimatedCost( const boost::filesystem::path &path, double costPerByte ) const
+{
+    boost::system::error_code error;
+    auto timing = mTimings.find( fs::canonical( path, error ).string() );
+    if( timing != mTimings.end() ){
+        return timing->second.mParseTime + timing->second.mVisitTime + timing->second.mEmitTime;
+    }
+    
+    uintmax_t fileSize = fs::file_size( path, error );
+    return ( error ? 0 : fileSize ) * costPerByte;
+}
+
+//! writes the chrome trace of the run and prints the time spent in every phase and by the most expensive headers
+void Parser::writeTrace( const std::string &path, Sink &sink )
+{
+    // the json strings only have to escape the quotes and backslashes of the headers paths
+    auto escape = []( std::string str ){
+        boost::replace_all( str, "\\", "\\\\" );
+        boost::replace_all( str, "\"", "\\\"" );
+        return str;
+    };
+    
+    stringstream traceFile;
+    traceFile << fixed << setprecision( 3 );
+    traceFile << "{ \"traceEvents\": [" << endl;
+    for( size_t i = 0; i < mTrace.mEvents.size(); i++ ){
+        const TraceEvent &event = mTrace.mEvents[i];
+        traceFile << "\t" << "{ \"name\": \"" << escape( event.mName ) << "\", \"cat\": \"" << event.mCategory << "\", \"ph\": \"X\", \"ts\": " << event.mStart << ", \"dur\": " << event.mDuration;
+        traceFile << ", \"pid\": " << event.mProcess << ", \"tid\": " << event.mThread << ", \"args\": { \"header\": \"" << escape( event.mHeader ) << "\" } }" << ( i + 1 < mTrace.mEvents.size() ? "," : "" ) << endl;
+    }
+    traceFile << "] }" << endl;
+    sink.write( path, traceFile.str() );
+    
+    // the summary of the phases, nested spans are also counted in their parents
+    map<string,vector<double>> phases;
+    map<string,double> headers;
+    for( auto event : mTrace.mEvents ){
+        phases[event.mName].push_back( event.mDuration / 1000.0 );
+        if( !event.mHeader.empty() && ( event.mName == "frontend" || event.mName == "emit" ) ){
+            headers[event.mHeader] += event.mDuration / 1000.0;
+        }
+    }
+    
+    cout << endl << left << setw( 28 ) << "phase" << right << setw( 10 ) << "count" << setw( 14 ) << "total ms" << setw( 12 ) << "mean ms" << setw( 12 ) << "max ms" << endl;
+    for( auto phase : phases ){
+        double total = accumulate( phase.second.begin(), phase.second.end(), 0.0 );
+        double longest = *max_element( phase.second.begin(), phase.second.end() );
+        cout << left << setw( 28 ) << phase.first << right << setw( 10 ) << phase.second.size() << fixed << setprecision( 2 ) << setw( 14 ) << total << setw( 12 ) << total / phase.second.size() << setw( 12 ) << longest << endl;
+    }
+    
+    vector<pair<double,string>> hotHeaders;
+    for( auto header : headers ){
+        hotHeaders.push_back( make_pair( header.second, header.first ) );
+    }
+    sort( hotHeaders.rbegin(), hotHeaders.rend() );
+    cout << endl << left << setw( 52 ) << "header" << right << setw( 14 ) << "ms" << endl;
+    for( size_t i = 0; i < std::min<size_t>( hotHeaders.size(), 10 ); i++ ){
+        cout << left << setw( 52 ) << hotHeaders[i].second << right << setw( 14 ) << hotHeaders[i].first << endl;
+    }
+    cout.unsetf( ios::floatfield );
+    cout << setprecision( 6 );
+}
+
+//! prints the memory used by the most memory hungry headers
+void Parser::printMemoryReport() const
 {
-    // copy input string list to a vector of paths
-    vector<fs::path> inputs;
-    for( auto p : mOptions.getInputFileList() ){
-        inputs.push_back( fs::path( p ) );
+    // the headers reused from a previous run report what that run measured
+    vector<const HeaderRecord*> records;
+    for( const auto &record : mRecords ){
+        if( record.mMemory.mRssAfter ){
+            records.push_back( &record );
+        }
     }
+    sort( records.begin(), records.end(), []( const HeaderRecord* a, const HeaderRecord* b ){ return a->mMemory.getClangBytes() > b->mMemory.getClangBytes(); } );
     
-    fs::path inputDirectory = mOptions.getInputDirectory();
+    auto megabytes = []( size_t bytes ){ return bytes / ( 1024.0 * 1024.0 ); };
+    cout << endl << fixed << setprecision( 2 );
+    cout << left << setw( 40 ) << "header" << right << setw( 10 ) << "ast MB" << setw( 12 ) << "tables MB" << setw( 12 ) << "sources MB" << setw( 12 ) << "output KB" << setw( 12 ) << "rss MB" << setw( 12 ) << "rss +MB" << endl;
+    for( size_t i = 0; i < std::min( records.size(), mOptions.getMemoryReportCount() ); i++ ){
+        const HeaderMemory &memory = records[i]->mMemory;
+        cout << left << setw( 40 ) << records[i]->mHeader << right;
+        cout << setw( 10 ) << megabytes( memory.mAstBytes ) << setw( 12 ) << megabytes( memory.mSideTableBytes + memory.mSourceTableBytes );
+        cout << setw( 12 ) << megabytes( memory.mSourceMallocBytes + memory.mSourceMmapBytes ) << setw( 12 ) << memory.mOutputBytes / 1024.0;
+        cout << setw( 12 ) << megabytes( memory.mRssAfter ) << setw( 12 ) << megabytes( memory.mRssAfter > memory.mRssBefore ? memory.mRssAfter - memory.mRssBefore : 0 ) << endl;
+        
+        // the biggest output sections of the header
+        vector<pair<size_t,string>> sections;
+        for( auto section : memory.mSections ){
+            sections.push_back( make_pair( section.second, section.first ) );
+        }
+        sort( sections.rbegin(), sections.rend() );
+        cout << "    ";
+        for( size_t j = 0; j < std::min<size_t>( sections.size(), 3 ); j++ ){
+            cout << sections[j].second << " " << sections[j].first / 1024.0 << " KB  ";
+        }
+        cout << endl;
+    }
+    cout.unsetf( ios::floatfield );
+    cout << setprecision( 6 );
+}
+
+//! returns the current resident memory of the process in bytes
+size_t Parser::getResidentMemory()
+{
+#if defined( __APPLE__ )
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if( task_info( mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>( &info ), &count ) != KERN_SUCCESS ){
+        return 0;
+    }
+    return info.resident_size;
+#else
+    // the second field of statm is the resident size in pages
+    ifstream statm( "/proc/self/statm" );
+    size_t pages = 0, residentPages = 0;
+    statm >> pages >> residentPages;
+    return residentPages * sysconf( _SC_PAGESIZE );
+#endif
+}
+
+//! returns the modification time of every file the records depend on
+std::map<std::string,std::time_t> Parser::getFileStamps( const std::vector<HeaderRecord> &records )
+{
+    set<string> files;
+    for( auto record : records ){
+        files.insert( record.mPath );
+        for( auto edge : record.mIncludes ){
+            files.insert( edge.mIncluder );
+            if( !edge.mPath.empty() ){
+                files.insert( edge.mPath );
+            }
+        }
+    }
     
-    // if there's no inputFileList, recursively walk the inputDirectory
-    if( inputs.empty() ){
-        const vector<string>& excludeDirectories = mOptions.getExcludeDirectoryList();
-        fs::recursive_directory_iterator dir( inputDirectory ), end;
-        while ( dir != end )
-        {
-            const fs::path& current = dir->path();
-            
-            // skip .DS_Store and excludedDirectories
-            if( current.filename() == ".DS_Store" ||
-               find( excludeDirectories.begin(), excludeDirectories.end(), current.string() ) != excludeDirectories.end() ){
-                dir.no_push();
+    map<string,std::time_t> stamps;
+    for( auto file : files ){
+        boost::system::error_code error;
+        std::time_t stamp = fs::last_write_time( file, error );
+        if( !error ){
+            stamps[file] = stamp;
+        }
+    }
+    return stamps;
+}
+//! keeps the modification time of every file the emitted headers depend on, as they were when parsed
+void Parser::updateFileStamps( const Model &model )
+{
+    // the records the model doesn't have keep the stamps of the run that parsed them
+    map<string,std::time_t> previousStamps;
+    previousStamps.swap( mFileStamps );
+    for( auto record : mRecords ){
+        set<string> files;
+        files.insert( record.mPath );
+        for( auto edge : record.mIncludes ){
+            files.insert( edge.mIncluder );
+            if( !edge.mPath.empty() ){
+                files.insert( edge.mPath );
             }
-            // if we find a head, add it to the inputList
-            else if( !fs::is_directory( current ) && current.extension() == ".h" ){
-                inputs.push_back( current );
+        }
+        for( auto file : files ){
+            auto stamp = model.mFileStamps.find( file );
+            if( stamp != model.mFileStamps.end() ){
+                mFileStamps[file] = stamp->second;
             }
-            
-            ++dir;
+            else if( ( stamp = previousStamps.find( file ) ) != previousStamps.end() ){
+                mFileStamps[file] = stamp->second;
+            }
+        }
+    }
+}
+
+//! writes the include graph, the headers records and the modification time of every file of the graph
+void Parser::writeIncludeGraph( const std::string &path, Sink &sink )
+{
+    stringstream graphFile;
+    graphFile << "options" << "\t" << getOptionsKey() << endl;
+    for( auto stamp : mFileStamps ){
+        graphFile << "file" << "\t" << stamp.first << "\t" << static_cast<long long>( stamp.second ) << endl;
+    }
+    
+    // the usage is kept with the stamps of the scripts it was collected from
+    if( mUsage.mEnabled ){
+        for( auto stamp : mUsage.mScripts ){
+            graphFile << "script" << "\t" << stamp.first << "\t" << static_cast<long long>( stamp.second ) << endl;
+        }
+        graphFile << "usage" << "\t" << mUsage.mInputsKey << endl;
+        for( auto identifier : mUsage.mIdentifiers ){
+            graphFile << "identifier" << "\t" << identifier << endl;
+        }
+        for( auto type : mUsage.mTypes ){
+            graphFile << "used" << "\t" << type << endl;
         }
     }
     
-    stringstream globalDeclCalls;
-    stringstream globalDefCalls;
-    stringstream globalIncludes;
+    // the symbols are kept even when the usage isn't, editing a script doesn't parse the headers again
+    for( auto symbols : mCachedSymbols ){
+        writeHeaderSymbols( graphFile, symbols.first, symbols.second );
+    }
     
-    // run clang tool on each header
-    for( int i = 0; i < inputs.size(); i++ ){
-        fs::path path = inputs[i];
-        fs::path name = path.filename();
-        std::ifstream file( path.c_str() );
-        std::string code((std::istreambuf_iterator<char>(file)),
-                         std::istreambuf_iterator<char>());
-        
-        std::string currentDirName = path.parent_path().string();
-        boost::replace_all( currentDirName, mOptions.getInputDirectory(), "" );
+    // the records of the headers left out of this run stay cached for the next ones
+    for( auto record : mRecords ){
+        writeHeaderRecord( graphFile, record );
         
-        if( !currentDirName.empty() && currentDirName[0] == '/' ){
-            currentDirName = currentDirName.substr( 1 );
+        // the graph of this run is the one the next invalidations are computed from
+        mCachedRecords[record.mPath] = record;
+    }
+    sink.write( path, graphFile.str() );
+}
+
+//! returns the records of the model and the previous records of the input headers the model doesn't have
+std::vector<Parser::HeaderRecord> Parser::getMergedRecords( const Model &model, const Sink &sink ) const
+{
+    // the shards and the merge step have every header of their run
+    if( mOptions.isSharded() || mOptions.isMergeEnabled() ){
+        return model.mRecords;
+    }
+    
+    // the headers given to parse keep their new record, or none if they were skipped or failed
+    set<string> modelHeaders( model.mHeaders.begin(), model.mHeaders.end() );
+    for( auto record : model.mRecords ){
+        modelHeaders.insert( record.mPath );
+    }
+    bool hasMissingRecords = false;
+    for( auto cachedRecord : mCachedRecords ){
+        if( !modelHeaders.count( cachedRecord.first ) ){
+            hasMissingRecords = true;
+            break;
         }
-        
-        // make sure the output directory exists
-        if( !fs::exists( mOptions.getOutputDirectory() + "/" + currentDirName ) ){
-            fs::create_directory( mOptions.getOutputDirectory() + "/" + currentDirName );
+    }
+    if( !hasMissingRecords ){
+        return model.mRecords;
+    }
+    
+    // the previous records are only kept for the headers still found, in the order of a whole run
+    map<string,const HeaderRecord*> modelRecords;
+    for( const auto &record : model.mRecords ){
+        modelRecords[record.mPath] = &record;
+    }
+    vector<HeaderRecord> records;
+    set<string> mergedHeaders;
+    for( auto header : findHeaders() ){
+        boost::system::error_code error;
+        string canonicalPath = fs::canonical( header, error ).string();
+        if( error || !mergedHeaders.insert( canonicalPath ).second ){
+            continue;
         }
         
-       // cout << "Parsing " << ( currentDirName.empty() ? "/" : currentDirName + "/" ) + name.string() << endl;
-        
-        Output output;
-        
-        runToolOnCodeWithArgs( new FrontendAction( output, mOptions ), code, mOptions.getCompilerFlags(), name.string() );
-        
-        ofstream sourceFile( mOptions.getOutputDirectory() + "/" + ( currentDirName.empty() ? "" : currentDirName + "/" ) + name.stem().string() + ".cpp" );
-        ofstream headerFile( mOptions.getOutputDirectory() + "/" + ( currentDirName.empty() ? "" : currentDirName + "/" ) + name.stem().string() + ".h" );
-        
-        if( !mOptions.getLicense().empty() ){
-            sourceFile << mOptions.getLicense() << endl;
-            sourceFile << endl;
-            headerFile << mOptions.getLicense() << endl;
-            headerFile << endl;
+        auto modelRecord    = modelRecords.find( canonicalPath );
+        auto cachedRecord   = mCachedRecords.find( canonicalPath );
+        if( modelRecord != modelRecords.end() ){
+            records.push_back( *modelRecord->second );
         }
-        
-        // Header Header
-        headerFile << "#pragma once" << endl;
-        headerFile << endl;
-        headerFile << "class asIScriptEngine;" << endl;
-        headerFile << endl;
-        headerFile << "namespace as {" << endl;
-        headerFile << endl;
-        
-        
-        // Source Header
-        sourceFile << "#include \"" << name.string() << "\"" << endl;
-        globalIncludes << "#include \"" << name.string() << "\"" << endl;
-        sourceFile << endl;
-        sourceFile << "// Avoid having to inform include path if header is already include before" << endl;
-        sourceFile << "#ifndef ANGELSCRIPT_H" << endl;
-        sourceFile << "\t" << "#include <angelscript.h>" << endl;
-        sourceFile << "#endif" << endl;
-        sourceFile << endl;
-        sourceFile << "#include \"RegistrationHelper.h\"" << endl;
-        sourceFile << "#include \"" << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << "\"" << endl;
-        sourceFile << endl;
-        
-        sourceFile << endl;
-        sourceFile << "using namespace std;" << endl;
-        sourceFile << "using namespace ci;" << endl;
-        sourceFile << endl;
-        sourceFile << "namespace as {" << endl;
-        sourceFile << endl;
-        
-        
-        // Types
-        if( output.mDeclCalls.tellp() || output.mEnumsDecl.tellp() ){
-            headerFile << "\t" << "//! registers " << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << " Forward Declarations" << endl;
-            headerFile << "\t" << "void registerCinder" << name.stem().string() << "Declarations( asIScriptEngine* engine );" << endl;
-            
-            sourceFile << "\t" << "//! registers " << name.stem().string() << " Forward Declarations" << endl;
-            sourceFile << "\t" << "void registerCinder" << name.stem().string() << "Declarations( asIScriptEngine* engine )" << endl;
-            sourceFile << "\t" << "{" << endl;
-            sourceFile << output.mDeclCalls.str() << endl;
-            if( output.mEnumsDecl.tellp() ){
-                sourceFile << "\t\t" << "registerCinder" << name.stem().string() << "Enums( engine );" << endl;
-            }
-            sourceFile << "\t" << "}" << endl;
-            sourceFile << endl;
-            
-            globalDeclCalls << "\t" << "as::registerCinder" << name.stem().string() << "Declarations( engine );" << endl;
+        else if( !modelHeaders.count( canonicalPath ) && cachedRecord != mCachedRecords.end() && sink.exists( cachedRecord->second.mOutputPath + ".cpp" ) && sink.exists( cachedRecord->second.mOutputPath + ".h" ) ){
+            records.push_back( cachedRecord->second );
         }
-        
-        // Implemntations
-        if( output.mDefCalls.tellp() ){
-            headerFile << "\t" << "//! registers " << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << " Definitions" << endl;
-            headerFile << "\t" << "void registerCinder" << name.stem().string() << "Definitions( asIScriptEngine* engine );" << endl;
-            
-            sourceFile << "\t" << "//! registers " << name.stem().string() << " Definitions" << endl;
-            sourceFile << "\t" << "void registerCinder" << name.stem().string() << "Definitions( asIScriptEngine* engine )" << endl;
-            sourceFile << "\t" << "{" << endl;
-            sourceFile << output.mDefCalls.str() << endl;
-            if( output.mFunctionDef.tellp() ){
-                sourceFile << "\t\t" << "registerCinder" << name.stem().string() << "Functions( engine );" << endl;
-            }
-            sourceFile << "\t" << "}" << endl;
-            sourceFile << endl;
-            
-            globalDefCalls << "\t" << "as::registerCinder" << name.stem().string() << "Definitions( engine );" << endl;
+    }
+    
+    // the headers given to parse from outside of the inputs come last
+    for( auto record : model.mRecords ){
+        if( !mergedHeaders.count( record.mPath ) ){
+            records.push_back( record );
         }
-        
-        if( output.mDeclCalls.tellp() || output.mDefCalls.tellp() ){
-            headerFile << endl;
+    }
+    return records;
+}
+
+//! writes the depfiles of every header and the one of the whole run
+void Parser::writeDepfiles( const Model &model, Sink &sink )
+{
+    // the whole run depends on every header and script, the build system runs it again when one of them changes
+    set<string> runDependencies( model.mHeaders.begin(), model.mHeaders.end() );
+    for( auto script : mUsage.mScripts ){
+        runDependencies.insert( script.first );
+    }
+    vector<string> runTargets = { mOptions.getOutputDirectory() + "/CinderBindings.stamp" };
+    stringstream stampFile;
+    
+    for( auto record : mRecords ){
+        set<string> dependencies = { record.mPath };
+        for( auto edge : record.mIncludes ){
+            if( !edge.mPath.empty() ){
+                dependencies.insert( edge.mPath );
+            }
         }
         
-        
-        // Enums
-        if( output.mEnumsDecl.tellp() ){
-            
-            headerFile << "\t" << "//! registers " << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << " Enums" << endl;
-            headerFile << "\t" << "void registerCinder" << name.stem().string() << "Enums( asIScriptEngine* engine );" << endl;
-            
-            
-            sourceFile << "\t" << "//! registers " << name.stem().string() << " Enums" << endl;
-            if( output.mEnumsExtras.tellp() ) sourceFile << endl << output.mEnumsExtras.str() << endl;
-            sourceFile << "\t" << "void registerCinder" << name.stem().string() << "Enums( asIScriptEngine* engine )" << endl;
-            sourceFile << "\t" << "{" << endl;
-            sourceFile << "\t\t" << "int r;" << endl;
-            sourceFile << endl;
-            sourceFile << output.mEnumsDecl.str() << endl;
-            sourceFile << endl;
-            sourceFile << "\t\t" << "// set back to empty default namespace " << endl;
-            sourceFile << "\t\t" << "r = engine->SetDefaultNamespace(\"\"); assert( r >= 0 );" << endl;
-            sourceFile << "\t" << "}" << endl;
-            sourceFile << endl;
+        string outputPath = mOptions.getOutputDirectory() + "/" + record.mOutputPath;
+        writeDepfile( record.mOutputPath + ".d", { outputPath + ".cpp", outputPath + ".h" }, dependencies, sink );
+        runDependencies.insert( dependencies.begin(), dependencies.end() );
+    }
+    
+    writeDepfile( "CinderBindings.d", runTargets, runDependencies, sink );
+    
+    // the stamp is the output the aggregate depfile is attached to
+    for( auto record : mRecords ){
+        stampFile << record.mOutputPath << endl;
+    }
+    sink.write( "CinderBindings.stamp", stampFile.str() );
+}
+
+//! writes a depfile listing the files the targets depend on
+void Parser::writeDepfile( const std::string &path, const std::vector<std::string> &targets, const std::set<std::string> &dependencies, Sink &sink )
+{
+    // make and ninja split the paths on spaces, they are escaped like gcc does
+    auto escape = []( std::string file ){
+        boost::replace_all( file, "$", "$$" );
+        boost::replace_all( file, "#", "\\#" );
+        boost::replace_all( file, " ", "\\ " );
+        return file;
+    };
+    
+    stringstream depfile;
+    for( size_t i = 0; i < targets.size(); i++ ){
+        depfile << ( i ? " " : "" ) << escape( targets[i] );
+    }
+    depfile << ":";
+    for( auto dependency : dependencies ){
+        depfile << " \\" << endl << "  " << escape( dependency );
+    }
+    depfile << endl;
+    
+    sink.write( path, depfile.str() );
+}
+
+//! returns the files of the previous run graph modified or removed since
+std::set<std::string> Parser::getChangedFiles() const
+{
+    set<string> changedFiles;
+    for( auto file : mFileStamps ){
+        boost::system::error_code error;
+        std::time_t stamp = fs::last_write_time( file.first, error );
+        if( error || stamp != file.second ){
+            changedFiles.insert( file.first );
         }
-        
-        // Functions
-        if( output.mFunctionDef.tellp() ){
-            headerFile << "\t" << "//! registers " << "cinder" << "/" << currentDirName << ( currentDirName.empty() ? "" : "/" ) << name.string() << " functions" << endl;
-            headerFile << "\t" << "void registerCinder" << name.stem().string() << "Functions( asIScriptEngine* engine );" << endl;
-            
-            sourceFile << "\t" << "//! registers " << name.stem().string() << " functions" << endl;
-            sourceFile << "\t" << "void registerCinder" << name.stem().string() << "Functions( asIScriptEngine* engine )" << endl;
-            sourceFile << "\t" << "{" << endl;
-            sourceFile << "\t\t" << "int r;" << endl;
-            sourceFile << endl;
-            sourceFile << output.mFunctionDef.str() << endl;
-            
-            // close the namespace
-            if( !output.mCurrentFunctionScope.empty() ){
-                sourceFile << endl;
-                sourceFile << "\t\t" << "// set back to empty default namespace " << endl;
-                sourceFile << "\t\t" << "r = engine->SetDefaultNamespace(\"\"); assert( r >= 0 );" << endl;
+    }
+    return changedFiles;
+}
+
+//! returns the files that include one of the changed files, directly or through other headers, including the changed files
+std::set<std::string> Parser::getInvalidatedHeaders( const std::set<std::string> &changedFiles ) const
+{
+    // reverse the edges of the graph, from an included file to the files including it
+    map<string,set<string>> includers;
+    for( auto record : mCachedRecords ){
+        for( auto edge : record.second.mIncludes ){
+            if( !edge.mPath.empty() ){
+                includers[edge.mPath].insert( edge.mIncluder );
             }
-            
-            sourceFile << "\t" << "}" << endl;
-            sourceFile << endl;
+        }
+    }
+    
+    set<string> invalidated;
+    deque<string> files( changedFiles.begin(), changedFiles.end() );
+    while( !files.empty() ){
+        string file = files.front();
+        files.pop_front();
+        if( !invalidated.insert( file ).second ){
+            continue;
         }
         
-        // Header declaration
-        if( output.mClassDecl.tellp() ) headerFile << output.mClassDecl.str() << endl;
-        if( output.mClassFieldDecl.tellp() ) headerFile << output.mClassFieldDecl.str() << endl;
-        if( output.mClassMethodDecl.tellp() ) headerFile << output.mClassMethodDecl.str() << endl;
-        if( output.mTemplatesDecl.tellp() ) headerFile << output.mTemplatesDecl.str() << endl;
-        
-        // Source Definitions
-        if( output.mClassExtras.tellp() ) sourceFile << output.mClassExtras.str() << endl;
-        if( output.mClassDef.tellp() ) sourceFile << output.mClassDef.str() << endl;
-        if( output.mClassFieldDef.tellp() ) sourceFile << output.mClassFieldDef.str() << endl;
-        if( output.mClassMethodDef.tellp() ) sourceFile << output.mClassMethodDef.str() << endl;
-        if( output.mTemplatesDef.tellp() ) sourceFile << output.mTemplatesDef.str() << endl;
-        if( output.mTemplatesSpec.tellp() ) sourceFile << output.mTemplatesSpec.str() << endl;
-        
-        headerFile << endl;
-        headerFile << "}" << endl;
-        
-        sourceFile << "}" << endl;
-        sourceFile.close();
-        headerFile.close();
-        
-        //cout << endl << endl << endl << output.mDefs.str() << endl << endl << endl;
+        auto fileIncluders = includers.find( file );
+        if( fileIncluders != includers.end() ){
+            files.insert( files.end(), fileIncluders->second.begin(), fileIncluders->second.end() );
+        }
     }
+    return invalidated;
+}
+
+#if defined( CLANG_PARSER_BENCHMARKS )
+//! the Visitor and the output and usage it writes to
+struct Parser::VisitorHelpers::Fixture {
+    Fixture( clang::ASTContext* context, const Options &options ) : mOptions( options ), mVisitor( context, mOutput, mOptions, mUsage ) {}
     
-    cout << globalIncludes.str() << endl << endl << globalDeclCalls.str() << endl << endl << globalDefCalls.str() << endl;
+    Options mOptions;
+    Output  mOutput;
+    Usage   mUsage;
+    Visitor mVisitor;
+};
+
+Parser::VisitorHelpers::VisitorHelpers( clang::ASTContext* context, const Options &options )
+: mFixture( new Fixture( context, options ) )
+{
+}
+
+Parser::VisitorHelpers::~VisitorHelpers()
+{
+}
+
+//! adds a namespace alias the names are written with
+void Parser::VisitorHelpers::addNamespaceAlias( clang::NamespaceAliasDecl *alias )
+{
+    mFixture->mVisitor.VisitNamespaceAliasDecl( alias );
+}
+
+std::string Parser::VisitorHelpers::getTypeName( const clang::QualType &type )
+{
+    return mFixture->mVisitor.getTypeName( type );
+}
+
+std::string Parser::VisitorHelpers::getTypeQualifiedName( const clang::QualType &type )
+{
+    return mFixture->mVisitor.getTypeQualifiedName( type );
+}
+
+std::string Parser::VisitorHelpers::getDeclarationQualifiedName( clang::NamedDecl *declaration )
+{
+    return mFixture->mVisitor.getDeclarationQualifiedName( declaration );
+}
+
+std::string Parser::VisitorHelpers::getFunctionArgList( clang::FunctionDecl *function )
+{
+    return mFixture->mVisitor.getFunctionArgList( function );
+}
+
+std::string Parser::VisitorHelpers::styleScopedName( const std::string &name )
+{
+    return mFixture->mVisitor.styleScopedName( name );
+}
+
+std::string Parser::VisitorHelpers::replaceNamespacesByAliases( const std::string &name )
+{
+    return mFixture->mVisitor.replaceNamespacesByAliases( name );
+}
+
+bool Parser::VisitorHelpers::isSupported( const std::string &name )
+{
+    return mFixture->mVisitor.isSupported( name );
 }
+#endif
 
 //! visits exceptions
 bool Parser::Visitor::VisitCXXThrowExpr(clang::CXXThrowExpr *declaration)
 {
     if( isInMainFile( declaration ) ){
     //   ( declaration->getAccess() == AS_public || declaration->getAccess() == AS_none ) ){
+        TraceSpan span( mOutput.mTrace, "VisitCXXThrowExpr", "visit" );
         
        cout << "\tExc:" << declToString( declaration ) << " " << endl;
         
@@ -253,6 +2614,7 @@ bool Parser::Visitor::VisitEnumDecl(clang::EnumDecl *declaration)
 {
     if( isInMainFile( declaration ) &&
        ( declaration->getAccess() == AS_public || declaration->getAccess() == AS_none ) ){
+        TraceSpan span( mOutput.mTrace, "VisitEnumDecl", "visit" );
         
         string name      = declaration->getNameAsString();
         if( name.empty() ){
@@ -261,6 +2623,18 @@ bool Parser::Visitor::VisitEnumDecl(clang::EnumDecl *declaration)
             }
         }
         
+        // add the enum to the model
+        EnumRef enumModel = Object::createEnum( name );
+        for( EnumDecl::enumerator_iterator it = declaration->enumerator_begin(), endIt = declaration->enumerator_end(); it != endIt; ++it ){
+            enumModel->addValue( (*it)->getNameAsString() );
+        }
+        mOutput.mEnums.push_back( enumModel );
+        
+        // skip the enums the scripts never reach
+        if( !name.empty() && !mUsage.isTypeUsed( name ) ){
+            return true;
+        }
+        
         string fullScope = getFullScope( declaration, name );
         if( !fullScope.empty() && mOutput.mCurrentEnumScope != fullScope ){
             
@@ -273,6 +2647,7 @@ bool Parser::Visitor::VisitEnumDecl(clang::EnumDecl *declaration)
         
         if( !name.empty() ){
             mOutput.mEnumsDecl << "\t\t" << "r = engine->RegisterEnum( " + quote( name ) + " ); assert( r >= 0 );" << endl;
+            mOutput.mDeclaredTypes.push_back( name );
         }
         
         for( EnumDecl::enumerator_iterator it = declaration->enumerator_begin(), endIt = declaration->enumerator_end(); it != endIt; ++it ){
@@ -281,7 +2656,7 @@ bool Parser::Visitor::VisitEnumDecl(clang::EnumDecl *declaration)
             if( !name.empty() ){
                 mOutput.mEnumsDecl << "\t\t" << "r = engine->RegisterEnumValue( " + quote( name ) + ", " + quote( enumDecl->getNameAsString() ) + ", " + ( fullScope.empty() ? "" : fullScope + "::" ) + ( name.empty() ? "" : name + "::" ) +  enumDecl->getNameAsString() + "); assert( r >= 0 );" << endl;
             }
-            else {
+            else if( mUsage.isIdentifierUsed( enumDecl->getNameAsString() ) ){
                 string constName = "AS_CONST_" + enumDecl->getNameAsString();
                 mOutput.mEnumsExtras << "\t" << "static int " << constName << " = " << ( fullScope.empty() ? "" : fullScope + "::" ) + enumDecl->getNameAsString() << ";"  << endl;
                 mOutput.mEnumsDecl << "\t\t" << "r = engine->RegisterGlobalProperty( " << quote( "const int " + enumDecl->getNameAsString() ) << ", &" << constName << "); assert( r >= 0 );" << endl;
@@ -302,6 +2677,8 @@ bool Parser::Visitor::VisitNamespaceAliasDecl(clang::NamespaceAliasDecl *declara
 bool Parser::Visitor::VisitNamespaceDecl(clang::NamespaceDecl *declaration)
 {
     if( isInMainFile( declaration ) ){
+        TraceSpan span( mOutput.mTrace, "VisitNamespaceDecl", "visit" );
+        
         string ns = declaration->getNameAsString();
         if( mNamespaceAliases.count( ns ) > 0 ){
             ns = mNamespaceAliases[ns]->getNameAsString();
@@ -322,20 +2699,38 @@ static map<string, string> typeSuffixes = {
 //! visits typedefs
 bool Parser::Visitor::VisitTypedefDecl(clang::TypedefDecl *declaration)
 {
-    
     if( isInMainFile( declaration ) ){ //&&
        //( declaration->getAccess() == AS_public || declaration->getAccess() == AS_none ) ){
+        TraceSpan span( mOutput.mTrace, "VisitTypedefDecl", "visit" );
         
         string scope = getFullScope( declaration->getDeclContext() );
         
         QualType type = declaration->getTypeSourceInfo()->getType();
-        if( const Type *typePtr = type.getTypePtr() ){
+        
+        // Ref typedefs are registered as value types holding the shared_ptr
+        if( CXXRecordDecl* record = getSharedRefRecord( mContext->getTypedefType( declaration ) ) ){
+            string name = declaration->getNameAsString();
+            if( isSharedRefRegistered( declaration ) ){
+                QualType recordType = mContext->getRecordType( record );
+                writeRegistrationCall( mOutput.mDeclCalls, name, "registerSharedRefType", "<" + getTypeQualifiedName( recordType ) + ">( engine, " + quote( name ) + " )" );
+                writeRegistrationCall( mOutput.mDefCalls, name, "registerSharedRefMethods", "<" + getTypeQualifiedName( recordType ) + ">( engine, " + quote( name ) + ", " + quote( getTypeName( recordType ) ) + " )" );
+                mOutput.mDeclaredTypes.push_back( name );
+                mOutput.mHasSharedRefs = true;
+                addSharedRef( mContext->getTypedefType( declaration ) );
+                
+                // get hands the scripts the object the shared_ptr owns, its factory count can't be intrusive
+                addEscapingType( mContext->getTypedefType( declaration ) );
+            }
+        }
+        else if( const Type *typePtr = type.getTypePtr() ){
             if( const TemplateSpecializationType *templateType = typePtr->getAs<TemplateSpecializationType>() ){
                 // cout << "\t Found a typedef of ";
                 
+                string templateName;
                 string templateQualifiedName;
                 string templateMangleName;
                 if( TemplateDecl *templateDecl = templateType->getTemplateName().getAsTemplateDecl() ){
+                    templateName            = getDeclarationName( templateDecl );
                     templateQualifiedName   = getDeclarationQualifiedName( templateDecl );
                     templateMangleName      = getMangleName( templateDecl );
                 }
@@ -372,44 +2767,27 @@ bool Parser::Visitor::VisitTypedefDecl(clang::TypedefDecl *declaration)
                     }
                 }
                 
-                if( !templateQualifiedName.empty() && !templateArgs.empty() && numArgs == 1 ){
+                // add the typedef to the model
+                if( !templateName.empty() ){
+                    mOutput.mTemplateTypedefs[declaration->getNameAsString()] = templateName;
+                }
+                
+                // and skip it if the scripts never reach it
+                if( !templateQualifiedName.empty() && !templateArgs.empty() && numArgs == 1 && mUsage.isTypeUsed( declaration->getNameAsString() ) ){
                     
                     if( find( mOutput.mClassesNames.begin(), mOutput.mClassesNames.end(), templateMangleName ) != mOutput.mClassesNames.end() ){
-                        mOutput.mDeclCalls << "\t\t" << "register" << styleScopedName( templateQualifiedName ) <<  "Type<" << templateArgs << ">( engine, " << quote( declaration->getNameAsString() ) << " );" << endl;
+                        writeRegistrationCall( mOutput.mDeclCalls, declaration->getNameAsString(), "register" + styleScopedName( templateQualifiedName ) + "Type", "<" + templateArgs + ">( engine, " + quote( declaration->getNameAsString() ) + " )" );
+                        mOutput.mDeclaredTypes.push_back( declaration->getNameAsString() );
                         
-                        string templateSpecialization = "template void register" + styleScopedName( templateQualifiedName ) +  "Type<" + templateArgs + ">( asIScriptEngine*, const std::string & );";
-                        if( mOutput.mTemplatesSpec.str().find( templateSpecialization ) == string::npos ){
-                            
-                            mOutput.mTemplatesSpec << endl << "\t" << "// " << templateQualifiedName << " template specializations so we can keep our implementation in the cpp file" << endl;
-                           // mOutput.mTemplatesSpec << "\t" << "template class " << styleScopedName( templateQualifiedName ) << "Factory<" << templateArgs <<">;" << endl;
-                            //mOutput.mTemplatesSpec << "\t" << "template<> std::map<" << templateQualifiedName << "<" << templateArgs << ">*, uint32_t> " << styleScopedName( templateQualifiedName ) << "Factory<" << templateArgs <<">::sRefs;" << endl;
-
-                            //mOutput.mTemplatesSpec << "\t" << "class " << styleScopedName( templateQualifiedName ) << "Factory<" << templateArgs << "> ;" << endl;
-                            //mOutput.mTemplatesSpec << "\t" << "public:" << endl;
-                            //mOutput.mTemplatesSpec << "\t\t" << "std::map<" << templateQualifiedName << "<" << templateArgs << ">" << "*, uint32_t> sRefs;" << endl;
-                            //mOutput.mTemplatesSpec << "\t" << "};" << endl;
-                            
-                            //mOutput.mTemplatesSpec << "\t" << "template<typename T> std::map<" << templateQualifiedName << "<T>*, uint32_t> " << styleScopedName( templateQualifiedName ) << "Factory<T>::sRefs;" << endl;
-                            //mOutput.mTemplatesSpec << endl;
-                            mOutput.mTemplatesSpec << "\t" << templateSpecialization << endl;
-                        }
-
+                        mOutput.mTemplateInstantiations.insert( "template void register" + styleScopedName( templateQualifiedName ) +  "Type<" + templateArgs + ">( asIScriptEngine*, const std::string & );" );
                     }
                     if( find( mOutput.mClassesWithFields.begin(), mOutput.mClassesWithFields.end(), templateMangleName ) != mOutput.mClassesWithFields.end() ){
-                        mOutput.mDefCalls << "\t\t" << "register" << styleScopedName( templateQualifiedName ) <<  "Fields<" << templateArgs << ">( engine, " << quote( declaration->getNameAsString() ) << ", " << quote( templateArgs ) << " );" << endl;
-                        
-                        string templateSpecialization = "template void register" + styleScopedName( templateQualifiedName ) +  "Fields<" + templateArgs + ">";
-                        if( mOutput.mTemplatesSpec.str().find( templateSpecialization ) == string::npos ){
-                            mOutput.mTemplatesSpec << "\t" << templateSpecialization << "( asIScriptEngine*, const std::string &, const std::string & );" << endl;
-                        }
+                        writeRegistrationCall( mOutput.mDefCalls, declaration->getNameAsString(), "register" + styleScopedName( templateQualifiedName ) + "Fields", "<" + templateArgs + ">( engine, " + quote( declaration->getNameAsString() ) + ", " + quote( templateArgs ) + " )" );
+                        mOutput.mTemplateInstantiations.insert( "template void register" + styleScopedName( templateQualifiedName ) +  "Fields<" + templateArgs + ">( asIScriptEngine*, const std::string &, const std::string & );" );
                     }
                     if( find( mOutput.mClassesWithMethods.begin(), mOutput.mClassesWithMethods.end(), templateMangleName ) != mOutput.mClassesWithMethods.end() ){
-                        mOutput.mDefCalls << "\t\t" << "register" << styleScopedName( templateQualifiedName ) <<  "Methods<" << templateArgs << ">( engine, " << quote( declaration->getNameAsString() ) << ", " << quote( templateArgs ) << ", " << quote( typeSuffixes[ templateArgs ] ) << " );" << endl;
-                        
-                        string templateSpecialization = "template void register" + styleScopedName( templateQualifiedName ) +  "Methods<" + templateArgs + ">";
-                        if( mOutput.mTemplatesSpec.str().find( templateSpecialization ) == string::npos ){
-                            mOutput.mTemplatesSpec << "\t" << templateSpecialization <<  "( asIScriptEngine*, const std::string &, const std::string &, const std::string & );" << endl;
-                        }
+                        writeRegistrationCall( mOutput.mDefCalls, declaration->getNameAsString(), "register" + styleScopedName( templateQualifiedName ) + "Methods", "<" + templateArgs + ">( engine, " + quote( declaration->getNameAsString() ) + ", " + quote( templateArgs ) + ", " + quote( typeSuffixes[ templateArgs ] ) + " )" );
+                        mOutput.mTemplateInstantiations.insert( "template void register" + styleScopedName( templateQualifiedName ) +  "Methods<" + templateArgs + ">( asIScriptEngine*, const std::string &, const std::string &, const std::string & );" );
                     }
                 }
                 
@@ -443,6 +2821,7 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
        //!declaration->isEmpty() &&
        //!declaration->isHidden() &&
        ( declaration->getAccess() == AS_public || declaration->getAccess() == AS_none ) ){
+        TraceSpan span( mOutput.mTrace, "VisitCXXRecordDecl", "visit" );
         
         // get class names
         string className                    = getDeclarationName( declaration );
@@ -483,6 +2862,16 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
             else return true;
         }
         
+        // add the class to the model
+        ClassRef classModel = Object::createClass( className );
+        classModel->uniqueName( mangleName ).templated( isTemplate );
+        mOutput.mClasses.push_back( classModel );
+        
+        // skip the classes the scripts never reach
+        if( !mUsage.isTypeUsed( className ) ){
+            return true;
+        }
+        
         stringstream *declStream;
         stringstream *defStream;
         
@@ -498,18 +2887,38 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                 defStream   = &mOutput.mTemplatesDef;
             }
             
+            // the templates factories are only compiled with the templates instantiations
+            stringstream *extrasStream = isTemplate ? &mOutput.mTemplatesExtras : &mOutput.mClassExtras;
             
             // create object factory
             string qualifiedName = classQualifiedName;
-            mOutput.mClassExtras << "\t" << "//! " << qualifiedName << " RefCounting and Object Factories" << endl;
+            (*extrasStream) << "\t" << "//! " << qualifiedName << " RefCounting and Object Factories" << endl;
             if( isTemplate ){
                 qualifiedName = templateClassQualifiedName;
-                mOutput.mClassExtras << "\t" << "template<typename T>" << endl;
+                (*extrasStream) << "\t" << "template<typename T>" << endl;
+            }
+            (*extrasStream) << "\t" << "class " << classQualifiedStyledName << "Factory {" << endl;
+            (*extrasStream) << "\t" << "public:" << endl;
+            
+            // the count only lives with the object if every pointer the scripts get comes from the factory,
+            // which is only known once every header is parsed, the templates instantiations always use the map
+            if( hasIntrusiveRefCount() ){
+                if( !isTemplate ){
+                    mOutput.mFactoryTypes.insert( mangleName );
+                    (*extrasStream) << "#if defined( CINDER_FACTORY_ONLY_" << mangleName << " )" << endl;
+                    (*extrasStream) << "\t\t" << "typedef " << getRefCountedType( qualifiedName, true ) << " RefCount;" << endl;
+                    (*extrasStream) << "#else" << endl;
+                    (*extrasStream) << "\t\t" << "typedef " << getRefCountedType( qualifiedName, false ) << " RefCount;" << endl;
+                    (*extrasStream) << "#endif" << endl;
+                }
+                else {
+                    (*extrasStream) << "\t\t" << "typedef " << getRefCountedType( qualifiedName, false ) << " RefCount;" << endl;
+                }
+                (*extrasStream) << endl;
             }
-            mOutput.mClassExtras << "\t" << "class " << classQualifiedStyledName << "Factory {" << endl;
-            mOutput.mClassExtras << "\t" << "public:" << endl;
             
             // starting type function
+            std::streampos typeStart = defStream->tellp();
             if( !isTemplate ){
                 (*defStream) << "\t" << "//! registers " << classQualifiedName << " class" << endl;
                 (*defStream) << "\t" << "void register" << classQualifiedStyledName << "Type( asIScriptEngine* engine )" << endl;
@@ -535,7 +2944,8 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
             (*defStream) << "\t\t" << "// register the object type " << endl;
             
             if( !isTemplate ){
-                mOutput.mDeclCalls << "\t\t" << "register" << classQualifiedStyledName << "Type( engine );" << endl;
+                writeRegistrationCall( mOutput.mDeclCalls, className, "register" + classQualifiedStyledName + "Type", "( engine )" );
+                mOutput.mDeclaredTypes.push_back( className );
                 
                 (*declStream) << "\t" << "//! registers " << classQualifiedName << " class" << endl;
                 (*declStream) << "\t" << "void register" << classQualifiedStyledName << "Type( asIScriptEngine* engine );" << endl;
@@ -568,6 +2978,7 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
             (*defStream) << "\t" << "}" << endl;
             (*defStream) << endl;
             
+            countRegistrations( *defStream, typeStart, "register" + classQualifiedStyledName + "Type" );
             mOutput.mClassesNames.push_back( mangleName );
         }
         
@@ -577,6 +2988,8 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
         bool hasPublicDestructor = false;
         bool hasPublicMethods = false;
         bool isStaticNamespace = false;
+        std::streampos fieldsStart;
+        std::streampos methodsStart;
         
         // Fields
         
@@ -584,8 +2997,8 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
             for( CXXRecordDecl::field_iterator it = declaration->field_begin(), endIt = declaration->field_end(); it != endIt; ++it ){
                 FieldDecl* field = *it;
                 
-                // skip private and implicit fields
-                if( field->getAccess() == AS_public && !field->isImplicit() ){
+                // skip private and implicit fields and the ones the scripts never use
+                if( field->getAccess() == AS_public && !field->isImplicit() && mUsage.isMemberUsed( className, getDeclarationName( field ) ) ){
                     
                     declStream      = &mOutput.mClassFieldDecl;
                     defStream       = &mOutput.mClassFieldDef;
@@ -597,9 +3010,10 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                     
                     if( !hasPublicFields ){
                         hasPublicFields = true;
+                        fieldsStart = defStream->tellp();
                         
                         if( !isTemplate ){
-                            mOutput.mDefCalls << "\t\t" << "register" << classQualifiedStyledName << "Fields( engine );" << endl;
+                            writeRegistrationCall( mOutput.mDefCalls, className, "register" + classQualifiedStyledName + "Fields", "( engine )" );
                             
                             (*declStream) << "\t" << "//! registers " << classQualifiedName << " fields" << endl;
                             (*declStream) << "\t" << "void register" << classQualifiedStyledName << "Fields( asIScriptEngine* engine );" << endl;
@@ -632,6 +3046,11 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                     string fieldType            = getTypeName( field->getType() );
                     string fieldDecl            = fieldType + " " + fieldName;
                     
+                    addTypeDependency( field->getType() );
+                    addSharedRef( field->getType() );
+                    addEscapingType( field->getType() );
+                    classModel->addField( Field( fieldName ).type( fieldType ) );
+                    
                     // register the field
                     //mOutput.mClassImpls << "\t\t" << "// register " << name << " " << fieldDecl << endl;
                     if( !isSupported( fieldDecl ) ){
@@ -663,17 +3082,33 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
             (*defStream) << "\t" << "}" << endl;
             (*defStream) << endl;
             
+            removeUnusedResult( *defStream, fieldsStart );
+            countRegistrations( *defStream, fieldsStart, "register" + classQualifiedStyledName + "Fields" );
             mOutput.mClassesWithFields.push_back( mangleName );
         }
         
         // Methods
+        bool useBindingTable = mOptions.isTableRegistrationEnabled() && !isTemplate;
+        vector<BindingTableEntry> methodsTable;
+        
+        // trivial accessors registered as properties, skipping the names already used by a member
+        stringstream accessorsStream;
+        set<string> accessorsNames;
+        set<string> membersNames;
+        for( CXXRecordDecl::field_iterator it = declaration->field_begin(), endIt = declaration->field_end(); it != endIt; ++it ){
+            membersNames.insert( getDeclarationName( *it ) );
+        }
+        for( CXXRecordDecl::method_iterator it = declaration->method_begin(), endIt = declaration->method_end(); it != endIt; ++it ){
+            membersNames.insert( getDeclarationName( *it ) );
+        }
+        
         for( CXXRecordDecl::method_iterator it = declaration->method_begin(), endIt = declaration->method_end(); it != endIt; ++it ){
             CXXMethodDecl* method   = *it;
             bool isConstructor      = llvm::isa<clang::CXXConstructorDecl>( method );
             bool isDestructor       = llvm::isa<clang::CXXDestructorDecl>( method );
             
-            // skip private and implicit methods
-            if( method->getAccess() == AS_public && !method->isImplicit() ) {//&& !isConstructor && !isDestructor ){
+            // skip private and implicit methods and the ones the scripts never call
+            if( method->getAccess() == AS_public && !method->isImplicit() && mUsage.isMemberUsed( className, getDeclarationName( method ) ) ) {//&& !isConstructor && !isDestructor ){
                 
                 declStream      = &mOutput.mClassMethodDecl;
                 defStream       = &mOutput.mClassMethodDef;
@@ -686,9 +3121,10 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                 
                 if( !hasPublicMethods ){
                     hasPublicMethods = true;
+                    methodsStart = defStream->tellp();
                     
                     if( !isTemplate ){
-                        mOutput.mDefCalls << "\t\t" << "register" << classQualifiedStyledName << "Methods( engine );" << endl;
+                        writeRegistrationCall( mOutput.mDefCalls, className, "register" + classQualifiedStyledName + "Methods", "( engine )" );
                         
                         (*declStream) << "\t" << "//! registers " << classQualifiedName << " methods" << endl;
                         (*declStream) << "\t" << "void register" << classQualifiedStyledName << "Methods( asIScriptEngine* engine );" << endl;
@@ -705,20 +3141,34 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                     }
                     
                     (*defStream) << "\t" << "{" << endl;
-                    (*defStream) << "\t\t" << "int r;" << endl;
-                    (*defStream) << endl;
                     
-                    // set the namespace
-                    if( !classScope.empty() ){
-                        (*defStream) << "\t\t" << "// set the current namespace " << endl;
-                        (*defStream) << "\t\t" << "r = engine->SetDefaultNamespace( " + quote( classScope ) + " ); assert( r >= 0 );" << endl;
+                    // the binding table handles namespaces itself
+                    if( !useBindingTable ){
+                        (*defStream) << "\t\t" << "int r;" << endl;
+                        if( mOptions.isRegistrarEmitterEnabled() && !isTemplate ){
+                            (*defStream) << "\t\t" << "Registrar registrar( engine, " << quote( className ) << " );" << endl;
+                        }
                         (*defStream) << endl;
+                        
+                        // set the namespace
+                        if( !classScope.empty() ){
+                            (*defStream) << "\t\t" << "// set the current namespace " << endl;
+                            (*defStream) << "\t\t" << "r = engine->SetDefaultNamespace( " + quote( classScope ) + " ); assert( r >= 0 );" << endl;
+                            (*defStream) << endl;
+                        }
                     }
                 }
                 
                 // extract function params
                 string params               = "(" + ( method->getNumParams() > 0 ? " " + getFunctionArgList( method ) + " " : "" ) + ")" + ( method->isConst() ? " const" : "" );
                 string paramsTypes          = "(" + getFunctionArgTypeList( method ) + ")" + ( method->isConst() ? " const" : "" );
+                string scriptParams         = "(" + ( method->getNumParams() > 0 ? " " + getScriptArgList( method ) + " " : "" ) + ")" + ( method->isConst() ? " const" : "" );
+                
+                addFunctionDependencies( method );
+                addFunctionSharedRefs( method );
+                if( method->getResultType()->isReferenceType() || method->getResultType()->isPointerType() ){
+                    addEscapingType( method->getResultType() );
+                }
                 
                 // get return qualified type and function name
                 string returnQualifiedType  = getFunctionQualifiedReturnType( method );
@@ -726,7 +3176,17 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                 string methodCXXName        = methodName;
                 string asReturnType         = returnQualifiedType;
                 
-                if( method->getResultType().getTypePtr()->getTypeClass() != Type::TypeClass::Builtin && asReturnType.find( "const" ) == string::npos && asReturnType.find( "&" ) == string::npos ){
+                // add the method to the model
+                Method methodModel( methodCXXName );
+                methodModel.returnType( returnQualifiedType );
+                methodModel.statical( method->isStatic() );
+                for( unsigned int i = 0; i < method->getNumParams(); i++ ){
+                    ParmVarDecl* p = method->getParamDecl( i );
+                    methodModel.addParameter( getTypeQualifiedName( p->getType() ), p->getNameAsString() );
+                }
+                classModel->addMethod( methodModel );
+                
+                if( method->getResultType().getTypePtr()->getTypeClass() != Type::TypeClass::Builtin && asReturnType.find( "const" ) == string::npos && asReturnType.find( "&" ) == string::npos && !getSharedRefRecord( method->getResultType() ) ){
                     asReturnType += "@";
                 }
                 
@@ -742,10 +3202,15 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                     }
                 }
                 
+                // the methods using std::vector are bound through wrappers passing the vectors as views
+                string wrapperName;
+                string wrapperDecl;
+                bool isWrapped = !isTemplate && !isConstructor && !isDestructor && methodCXXName.find( "operator" ) == string::npos && writeWrapper( method, classQualifiedStyledName + "Factory", methodName, method->isStatic() ? returnQualifiedType : asReturnType, &wrapperName, &wrapperDecl );
+                
                 // register the method
                 // if method is not static declare it as ObjectMethod
                 if( !method->isStatic() ){
-                    if( isStaticNamespace ){
+                    if( isStaticNamespace && !useBindingTable ){
                         (*defStream) << endl;
                         (*defStream) << "\t\t" << "// set back the current namespace " << endl;
                         (*defStream) << "\t\t" << "r = engine->SetDefaultNamespace( " + quote( classScope ) + " ); assert( r >= 0 );" << endl;
@@ -756,38 +3221,113 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                     
                     // comment if we detect an unsupported type
                     bool isCommented = false;
-                    if( !isSupported( returnQualifiedType + methodName + params + paramsTypes + returnQualifiedType ) ){
-                        (*defStream) << "//";
+                    if( !isWrapped && !isSupported( returnQualifiedType + methodName + params + paramsTypes + returnQualifiedType ) ){
+                        if( !useBindingTable ) (*defStream) << "//";
                         isCommented = true;
                     }
                     
                     // if we still have "operator" in the method, then it means that it's not supported so comment it
                     if( methodName.find( "operator" ) != string::npos ){
-                        (*defStream) << "//";
+                        if( !useBindingTable ) (*defStream) << "//";
                         isCommented = true;
                     }
                     
                     // output the method
-                    string asMethodDecl = quote( asReturnType + " " + methodName + params );
+                    string asMethodDecl = quote( isWrapped ? wrapperDecl : asReturnType + " " + methodName + scriptParams );
                     
                     // TODO (Add as options?)
                     boost::replace_all( asMethodDecl, "std::string", "string" );
                     
                         if( !isTemplate ){
                             if( isConstructor ){
-                                mOutput.mClassExtras << "\t\t" << "static " << classQualifiedName << "* create" << params << endl;
-                                mOutput.mClassExtras << "\t\t" << "{" << endl;
-                                mOutput.mClassExtras << "\t\t\t" << classQualifiedName << " *ref = new " << classQualifiedName << "();" << endl;
-                                mOutput.mClassExtras << "\t\t\t" << "addRef( ref );" << endl;
-                                mOutput.mClassExtras << "\t\t\t" << "return ref;" << endl;
-                                mOutput.mClassExtras << "\t\t" << "}" << endl;
-                                (*defStream) << "\t\t" << "r = engine->RegisterObjectBehaviour( " << quote( className ) << ", asBEHAVE_FACTORY, " << quote( className + "@ f" + paramsTypes  ) << ", asFUNCTIONPR( " << classQualifiedStyledName << "Factory::create, " << paramsTypes << "," << classQualifiedName << "* ), asCALL_CDECL ); assert( r >= 0 );" << endl;
+                                (*extrasStream) << "\t\t" << "static " << classQualifiedName << "* create" << params << endl;
+                                (*extrasStream) << "\t\t" << "{" << endl;
+                                if( hasIntrusiveRefCount() ){
+                                    (*extrasStream) << "\t\t\t" << "return RefCount::create();" << endl;
+                                }
+                                else {
+                                    (*extrasStream) << "\t\t\t" << classQualifiedName << " *ref = new " << classQualifiedName << "();" << endl;
+                                    (*extrasStream) << "\t\t\t" << "addRef( ref );" << endl;
+                                    (*extrasStream) << "\t\t\t" << "return ref;" << endl;
+                                }
+                                (*extrasStream) << "\t\t" << "}" << endl;
+                                if( useBindingTable ){
+                                    BindingTableEntry entry = { "ObjectBehaviour", classScope, className, className + "@ f" + paramsTypes, "asFUNCTIONPR( " + classQualifiedStyledName + "Factory::create, " + paramsTypes + "," + classQualifiedName + "* )", "asCALL_CDECL", "asBEHAVE_FACTORY", isCommented };
+                                    methodsTable.push_back( entry );
+                                }
+                                else {
+                                    (*defStream) << "\t\t" << "r = engine->RegisterObjectBehaviour( " << quote( className ) << ", asBEHAVE_FACTORY, " << quote( className + "@ f" + paramsTypes  ) << ", asFUNCTIONPR( " << classQualifiedStyledName << "Factory::create, " << paramsTypes << "," << classQualifiedName << "* ), asCALL_CDECL ); assert( r >= 0 );" << endl;
+                                }
                             }
                             else if( !isDestructor ){
-                                (*defStream) << "\t\t" << "r = engine->RegisterObjectMethod( " << quote( className ) << ", " << asMethodDecl << ", asMETHODPR( " << classQualifiedName <<  ", " << methodCXXName << ", " << paramsTypes << ", " << returnQualifiedType << " ), asCALL_THISCALL ); assert( r >= 0 );" << endl;
+                                string methodPtr    = "asMETHODPR( " + classQualifiedName + ", " + methodCXXName + ", " + paramsTypes + ", " + returnQualifiedType + " )";
+                                string callConv     = "asCALL_THISCALL";
+                                if( isWrapped ){
+                                    methodPtr       = "asFUNCTION( " + wrapperName + " )";
+                                    callConv        = "asCALL_CDECL_OBJFIRST";
+                                }
+                                else if( mOptions.isCallCountersEnabled() && !isCommented ){
+                                    methodPtr       = getCountedBinding( "CountedMethod", returnQualifiedType + " (" + classQualifiedName + "::*)" + paramsTypes, classQualifiedName + "::" + methodCXXName, classQualifiedName + "::" + methodCXXName + paramsTypes );
+                                    callConv        = "asCALL_CDECL_OBJFIRST";
+                                }
+                                
+                                if( useBindingTable ){
+                                    BindingTableEntry entry = { "ObjectMethod", classScope, className, asMethodDecl.substr( 1, asMethodDecl.length() - 2 ), methodPtr, callConv, "0", isCommented };
+                                    methodsTable.push_back( entry );
+                                }
+                                else if( mOptions.isRegistrarEmitterEnabled() ){
+                                    // plain methods let the registrar deduce their pointer and calling convention
+                                    bool isPlain = callConv == "asCALL_THISCALL";
+                                    (*defStream) << "\t\t" << "registrar.method( " << asMethodDecl << ", " << ( isPlain ? getRegistrarPointer( method, classQualifiedName + "::" + methodCXXName, returnQualifiedType + " (" + classQualifiedName + "::*)" + paramsTypes ) : methodPtr + ", " + callConv ) << " );" << endl;
+                                }
+                                else {
+                                    (*defStream) << "\t\t" << "r = engine->RegisterObjectMethod( " << quote( className ) << ", " << asMethodDecl << ", " << methodPtr << ", " << callConv << " ); assert( r >= 0 );" << endl;
+                                }
+                                
+                                // a public field is read and written in place, a private one through a property accessor
+                                bool isSetter = false;
+                                FieldDecl* accessedField = mOptions.isAccessorPropertiesEnabled() && !isCommented && !isWrapped ? getTrivialAccessorField( method, &isSetter ) : nullptr;
+                                string propertyName = accessedField ? getAccessorPropertyName( methodCXXName, isSetter ) : "";
+                                if( !propertyName.empty() && !membersNames.count( propertyName ) ){
+                                    if( accessedField->getAccess() == AS_public ){
+                                        addEscapingType( accessedField->getType() );
+                                        string propertyDecl = getTypeName( accessedField->getType() ) + " " + propertyName;
+                                        if( isSupported( propertyDecl ) && accessorsNames.insert( propertyName ).second ){
+                                            accessorsStream << "\t\t" << "r = engine->RegisterObjectProperty( " << quote( className ) << ", " << quote( propertyDecl ) << ", asOFFSET( " << classQualifiedName <<  ", " << getDeclarationName( accessedField ) << " ) ); assert( r >= 0 );" << endl;
+                                        }
+                                    }
+                                    else {
+                                        string accessorName = ( isSetter ? "set_" : "get_" ) + propertyName;
+                                        string accessorDecl = ( isSetter ? "void" : asReturnType ) + " " + accessorName + scriptParams;
+                                        boost::replace_all( accessorDecl, "std::string", "string" );
+                                        if( accessorsNames.insert( accessorName ).second ){
+                                            accessorsStream << "\t\t" << "r = engine->RegisterObjectMethod( " << quote( className ) << ", " << quote( accessorDecl ) << ", asMETHODPR( " << classQualifiedName <<  ", " << methodCXXName << ", " << paramsTypes << ", " << returnQualifiedType << " ), asCALL_THISCALL ); assert( r >= 0 );" << endl;
+                                        }
+                                    }
+                                }
                             }
                         }
                         else {
+                            // the script declarations of the template use the name, type and suffix of the registered specialization
+                            auto getTemplateDeclaration = [&]( const string &declaration ){
+                                string quotedDecl = quote( declaration );
+                                boost::replace_all( quotedDecl, templateClassQualifiedName, "\" + name + \"" );
+                                boost::replace_all( quotedDecl, templateClassName, "\" + name + \"" );
+                                boost::replace_all( quotedDecl, classQualifiedName, "\" + name + \"" );
+                                boost::replace_all( quotedDecl, "<T>", "\" + suffix + \"" );
+                                
+                                // only the T standing on its own is the template parameter
+                                auto isIdentifierChar = []( char c ){ return isalnum( static_cast<unsigned char>( c ) ) || c == '_'; };
+                                string templateDecl;
+                                for( size_t i = 0; i < quotedDecl.length(); i++ ){
+                                    bool isParameter = quotedDecl[i] == 'T' && ( i == 0 || !isIdentifierChar( quotedDecl[i-1] ) ) && ( i + 1 == quotedDecl.length() || !isIdentifierChar( quotedDecl[i+1] ) );
+                                    templateDecl += isParameter ? "\" + type + \"" : string( 1, quotedDecl[i] );
+                                }
+                                boost::replace_all( templateDecl, "\"\" + ", "" );
+                                boost::replace_all( templateDecl, " + \"\"", "" );
+                                return templateDecl;
+                            };
+                            
                             string paramsAsTypes = paramsTypes;
                             if( !isCommented ){
                                 boost::replace_all( asMethodDecl, templateClassQualifiedName, "\" + name + \"" );
@@ -808,23 +3348,63 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                             }
                             
                             if( isConstructor ){
-                                mOutput.mClassExtras << "\t\t" << "static " << templateClassQualifiedName << "* create" << params << endl;
-                                mOutput.mClassExtras << "\t\t" << "{" << endl;
-                                mOutput.mClassExtras << "\t\t\t" << templateClassQualifiedName << " *ref = new " << templateClassQualifiedName << "();" << endl;
-                                mOutput.mClassExtras << "\t\t\t" << "addRef( ref );" << endl;
-                                mOutput.mClassExtras << "\t\t\t" << "return ref;" << endl;
-                                mOutput.mClassExtras << "\t\t" << "}" << endl;
+                                (*extrasStream) << "\t\t" << "static " << templateClassQualifiedName << "* create" << params << endl;
+                                (*extrasStream) << "\t\t" << "{" << endl;
+                                if( hasIntrusiveRefCount() ){
+                                    (*extrasStream) << "\t\t\t" << "return RefCount::create();" << endl;
+                                }
+                                else {
+                                    (*extrasStream) << "\t\t\t" << templateClassQualifiedName << " *ref = new " << templateClassQualifiedName << "();" << endl;
+                                    (*extrasStream) << "\t\t\t" << "addRef( ref );" << endl;
+                                    (*extrasStream) << "\t\t\t" << "return ref;" << endl;
+                                }
+                                (*extrasStream) << "\t\t" << "}" << endl;
                                 (*defStream) << "\t\t" << "r = engine->RegisterObjectBehaviour( name.c_str(), asBEHAVE_FACTORY, std::string( name + \"@ f" << paramsAsTypes << "\" ).c_str(), asFUNCTIONPR( " << classQualifiedStyledName << "Factory<T>::create, " << paramsTypes << ", " << templateClassQualifiedName << "* ), asCALL_CDECL ); assert( r >= 0 );" << endl;
                             }
                             else if( !isDestructor ){
                                 asMethodDecl = "std::string( " + asMethodDecl + " ).c_str()";
                                 (*defStream) << "\t\t" << "r = engine->RegisterObjectMethod( name.c_str(), " << asMethodDecl << ", asMETHODPR( " << templateClassQualifiedName <<  ", " << methodCXXName << ", " << paramsTypes << ", " << returnQualifiedType << " ), asCALL_THISCALL ); assert( r >= 0 );" << endl;
+                                
+                                // the accessors of the template are registered with its methods, every registered specialization gets them
+                                bool isSetter = false;
+                                FieldDecl* accessedField = mOptions.isAccessorPropertiesEnabled() && !isCommented ? getTrivialAccessorField( method, &isSetter ) : nullptr;
+                                string propertyName = accessedField ? getAccessorPropertyName( methodCXXName, isSetter ) : "";
+                                if( !propertyName.empty() && !membersNames.count( propertyName ) ){
+                                    if( accessedField->getAccess() == AS_public ){
+                                        addEscapingType( accessedField->getType() );
+                                        string propertyDecl = getTypeName( accessedField->getType() ) + " " + propertyName;
+                                        if( isSupported( propertyDecl ) && accessorsNames.insert( propertyName ).second ){
+                                            (*defStream) << "\t\t" << "r = engine->RegisterObjectProperty( name.c_str(), std::string( " << getTemplateDeclaration( propertyDecl ) << " ).c_str(), asOFFSET( " << templateClassQualifiedName <<  ", " << getDeclarationName( accessedField ) << " ) ); assert( r >= 0 );" << endl;
+                                        }
+                                    }
+                                    else {
+                                        string accessorName = ( isSetter ? "set_" : "get_" ) + propertyName;
+                                        string accessorDecl = ( isSetter ? "void" : asReturnType ) + " " + accessorName + scriptParams;
+                                        boost::replace_all( accessorDecl, "std::string", "string" );
+                                        if( accessorsNames.insert( accessorName ).second ){
+                                            (*defStream) << "\t\t" << "r = engine->RegisterObjectMethod( name.c_str(), std::string( " << getTemplateDeclaration( accessorDecl ) << " ).c_str(), asMETHODPR( " << templateClassQualifiedName <<  ", " << methodCXXName << ", " << paramsTypes << ", " << returnQualifiedType << " ), asCALL_THISCALL ); assert( r >= 0 );" << endl;
+                                        }
+                                    }
+                                }
                             }
                         }
                     
                     
                 }
                 // else declare it as GlobalFunction with a namespace
+                // (the binding table stores the class namespace with the entry)
+                else if( useBindingTable ){
+                    bool isCommented    = !isWrapped && !isSupported( returnQualifiedType + methodName + params + paramsTypes + returnQualifiedType );
+                    string functionPtr  = "asFUNCTIONPR( " + templateClassQualifiedName + "::" + methodName + ", " + paramsTypes + ", " + returnQualifiedType + " )";
+                    if( isWrapped ){
+                        functionPtr     = "asFUNCTION( " + wrapperName + " )";
+                    }
+                    else if( mOptions.isCallCountersEnabled() && !isCommented ){
+                        functionPtr     = getCountedBinding( "CountedFunction", returnQualifiedType + " (*)" + paramsTypes, templateClassQualifiedName + "::" + methodName, templateClassQualifiedName + "::" + methodName + paramsTypes );
+                    }
+                    BindingTableEntry entry = { "GlobalFunction", ( !classScope.empty() ? classScope + "::" : "" ) + className, "", isWrapped ? wrapperDecl : returnQualifiedType + " " + methodName + scriptParams, functionPtr, "asCALL_CDECL", "0", isCommented };
+                    methodsTable.push_back( entry );
+                }
                 else {
                     if( !isStaticNamespace ){
                         (*defStream) << endl;
@@ -841,12 +3421,29 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
                     }
                     
                     // comment if we detect an unsupported type
-                    if( !isSupported( returnQualifiedType + methodName + params + paramsTypes + returnQualifiedType ) ){
+                    bool isCommented = !isWrapped && !isSupported( returnQualifiedType + methodName + params + paramsTypes + returnQualifiedType );
+                    if( isCommented ){
                         (*defStream) << "//";
                     }
                     
                     if( !isTemplate ){
-                        (*defStream) << "\t\t" << "r = engine->RegisterGlobalFunction( " << quote( returnQualifiedType + " " + methodName + params ) << ", asFUNCTIONPR( " << templateClassQualifiedName <<  "::" << methodName << ", " << paramsTypes << ", " << returnQualifiedType << " ), asCALL_CDECL ); assert( r >= 0 );" << endl;
+                        string functionPtr = "asFUNCTIONPR( " + templateClassQualifiedName + "::" + methodName + ", " + paramsTypes + ", " + returnQualifiedType + " )";
+                        bool isPlain = true;
+                        if( isWrapped ){
+                            functionPtr = "asFUNCTION( " + wrapperName + " )";
+                            isPlain = false;
+                        }
+                        else if( mOptions.isCallCountersEnabled() && !isCommented ){
+                            functionPtr = getCountedBinding( "CountedFunction", returnQualifiedType + " (*)" + paramsTypes, templateClassQualifiedName + "::" + methodName, templateClassQualifiedName + "::" + methodName + paramsTypes );
+                            isPlain = false;
+                        }
+                        string functionDecl = quote( isWrapped ? wrapperDecl : returnQualifiedType + " " + methodName + scriptParams );
+                        if( mOptions.isRegistrarEmitterEnabled() ){
+                            (*defStream) << "\t\t" << "registrar.function( " << functionDecl << ", " << ( isPlain ? getRegistrarPointer( method, templateClassQualifiedName + "::" + methodCXXName, returnQualifiedType + " (*)" + paramsTypes ) : functionPtr + ", asCALL_CDECL" ) << " );" << endl;
+                        }
+                        else {
+                            (*defStream) << "\t\t" << "r = engine->RegisterGlobalFunction( " << functionDecl << ", " << functionPtr << ", asCALL_CDECL ); assert( r >= 0 );" << endl;
+                        }
                     }
                     else {
                         
@@ -858,8 +3455,11 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
         // if we have public methods we should close the method function
         if( hasPublicMethods ) {
             
+            if( useBindingTable ){
+                writeBindingTable( *defStream, methodsTable );
+            }
             // close the namespace
-            if( !classScope.empty() || isStaticNamespace ){
+            else if( !classScope.empty() || isStaticNamespace ){
                 (*defStream) << endl;
                 (*defStream) << "\t\t" << "// set back to empty default namespace " << endl;
                 (*defStream) << "\t\t" << "r = engine->SetDefaultNamespace(\"\"); assert( r >= 0 );" << endl;
@@ -870,9 +3470,41 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
             (*defStream) << "\t" << "}" << endl;
             (*defStream) << endl;
             
+            removeUnusedResult( *defStream, methodsStart );
+            countRegistrations( *defStream, methodsStart, "register" + classQualifiedStyledName + "Methods" );
             mOutput.mClassesWithMethods.push_back( mangleName );
         }
         
+        // accessors function
+        if( accessorsStream.tellp() ){
+            std::streampos accessorsStart = mOutput.mClassMethodDef.tellp();
+            
+            writeRegistrationCall( mOutput.mDefCalls, className, "register" + classQualifiedStyledName + "Accessors", "( engine )" );
+            
+            mOutput.mClassMethodDecl << "\t" << "//! registers " << classQualifiedName << " trivial accessors as properties" << endl;
+            mOutput.mClassMethodDecl << "\t" << "void register" << classQualifiedStyledName << "Accessors( asIScriptEngine* engine );" << endl;
+            mOutput.mClassMethodDef << "\t" << "//! registers " << classQualifiedName << " trivial accessors as properties" << endl;
+            mOutput.mClassMethodDef << "\t" << "void register" << classQualifiedStyledName << "Accessors( asIScriptEngine* engine )" << endl;
+            mOutput.mClassMethodDef << "\t" << "{" << endl;
+            mOutput.mClassMethodDef << "\t\t" << "int r;" << endl;
+            mOutput.mClassMethodDef << endl;
+            if( !classScope.empty() ){
+                mOutput.mClassMethodDef << "\t\t" << "// set the current namespace " << endl;
+                mOutput.mClassMethodDef << "\t\t" << "r = engine->SetDefaultNamespace( " + quote( classScope ) + " ); assert( r >= 0 );" << endl;
+                mOutput.mClassMethodDef << endl;
+            }
+            mOutput.mClassMethodDef << accessorsStream.str();
+            if( !classScope.empty() ){
+                mOutput.mClassMethodDef << endl;
+                mOutput.mClassMethodDef << "\t\t" << "// set back to empty default namespace " << endl;
+                mOutput.mClassMethodDef << "\t\t" << "r = engine->SetDefaultNamespace(\"\"); assert( r >= 0 );" << endl;
+            }
+            mOutput.mClassMethodDef << "\t" << "}" << endl;
+            mOutput.mClassMethodDef << endl;
+            
+            countRegistrations( mOutput.mClassMethodDef, accessorsStart, "register" + classQualifiedStyledName + "Accessors" );
+        }
+        
         
         if( !declaration->isEmpty() ){
             
@@ -881,27 +3513,43 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
             if( isTemplate ){
                 qualifiedName = templateClassQualifiedName;
             }
-            mOutput.mClassExtras << "\t\t" << "static void addRef( " << qualifiedName << " *ptr )" << endl;
-            mOutput.mClassExtras << "\t\t" << "{" << endl;
-            mOutput.mClassExtras << "\t\t\t" << "typename std::map<" << qualifiedName << "*,uint32_t>::iterator it = sRefs.find( ptr );" << endl;
-            mOutput.mClassExtras << "\t\t\t" << "if( it != sRefs.end() ){" << endl;
-            mOutput.mClassExtras << "\t\t\t\t" << "it->second++;" << endl;
-            mOutput.mClassExtras << "\t\t\t" << "}" << endl;
-            mOutput.mClassExtras << "\t\t\t" << "else {" << endl;
-            mOutput.mClassExtras << "\t\t\t\t" << "sRefs.insert( std::make_pair( ptr, 1 ) );" << endl;
-            mOutput.mClassExtras << "\t\t\t" << "}" << endl;
-            mOutput.mClassExtras << "\t\t" << "}" << endl;
-            mOutput.mClassExtras << endl;
-            mOutput.mClassExtras << "\t\t" << "static void release( " << qualifiedName << " *ptr )" << endl;
-            mOutput.mClassExtras << "\t\t" << "{" << endl;
-            mOutput.mClassExtras << "\t\t" << "}" << endl;
-            mOutput.mClassExtras << endl;
-            mOutput.mClassExtras << "\t" << "protected:" << endl;
-            mOutput.mClassExtras << "\t\t" << "static std::map<" << qualifiedName << "*, uint32_t> sRefs;" << endl;
-            mOutput.mClassExtras << "\t" << "};" << endl;
-            if( !isTemplate ) mOutput.mClassExtras << "\t" << "std::map<" << qualifiedName << "*, uint32_t> " << classQualifiedStyledName << "Factory::sRefs;" << endl;
-            else mOutput.mClassExtras << "\t" << "template<typename T> std::map<" << qualifiedName << "*, uint32_t> " << classQualifiedStyledName << "Factory<T>::sRefs;" << endl;
-            mOutput.mClassExtras << endl;
+            
+            // the reference count chosen when the factory was opened, thread safe either way
+            if( hasIntrusiveRefCount() ){
+                (*extrasStream) << "\t\t" << "static void addRef( " << qualifiedName << " *ptr )" << endl;
+                (*extrasStream) << "\t\t" << "{" << endl;
+                (*extrasStream) << "\t\t\t" << "RefCount::addRef( ptr );" << endl;
+                (*extrasStream) << "\t\t" << "}" << endl;
+                (*extrasStream) << endl;
+                (*extrasStream) << "\t\t" << "static void release( " << qualifiedName << " *ptr )" << endl;
+                (*extrasStream) << "\t\t" << "{" << endl;
+                (*extrasStream) << "\t\t\t" << "RefCount::release( ptr );" << endl;
+                (*extrasStream) << "\t\t" << "}" << endl;
+                (*extrasStream) << "\t" << "};" << endl;
+            }
+            else {
+                (*extrasStream) << "\t\t" << "static void addRef( " << qualifiedName << " *ptr )" << endl;
+                (*extrasStream) << "\t\t" << "{" << endl;
+                (*extrasStream) << "\t\t\t" << "typename std::map<" << qualifiedName << "*,uint32_t>::iterator it = sRefs.find( ptr );" << endl;
+                (*extrasStream) << "\t\t\t" << "if( it != sRefs.end() ){" << endl;
+                (*extrasStream) << "\t\t\t\t" << "it->second++;" << endl;
+                (*extrasStream) << "\t\t\t" << "}" << endl;
+                (*extrasStream) << "\t\t\t" << "else {" << endl;
+                (*extrasStream) << "\t\t\t\t" << "sRefs.insert( std::make_pair( ptr, 1 ) );" << endl;
+                (*extrasStream) << "\t\t\t" << "}" << endl;
+                (*extrasStream) << "\t\t" << "}" << endl;
+                (*extrasStream) << endl;
+                (*extrasStream) << "\t\t" << "static void release( " << qualifiedName << " *ptr )" << endl;
+                (*extrasStream) << "\t\t" << "{" << endl;
+                (*extrasStream) << "\t\t" << "}" << endl;
+                (*extrasStream) << endl;
+                (*extrasStream) << "\t" << "protected:" << endl;
+                (*extrasStream) << "\t\t" << "static std::map<" << qualifiedName << "*, uint32_t> sRefs;" << endl;
+                (*extrasStream) << "\t" << "};" << endl;
+                if( !isTemplate ) (*extrasStream) << "\t" << "std::map<" << qualifiedName << "*, uint32_t> " << classQualifiedStyledName << "Factory::sRefs;" << endl;
+                else (*extrasStream) << "\t" << "template<typename T> std::map<" << qualifiedName << "*, uint32_t> " << classQualifiedStyledName << "Factory<T>::sRefs;" << endl;
+            }
+            (*extrasStream) << endl;
             
         }
     }
@@ -911,16 +3559,38 @@ bool Parser::Visitor::VisitCXXRecordDecl(clang::CXXRecordDecl *declaration)
 bool Parser::Visitor::VisitFunctionDecl( clang::FunctionDecl *function )
 {
     if( isInMainFile( function ) && function->getAccess() == AS_none ){
+        TraceSpan span( mOutput.mTrace, "VisitFunctionDecl", "visit" );
         
         // extract function params
         string params               = "(" + ( function->getNumParams() > 0 ? " " + getFunctionArgList( function ) + " " : "" ) + ")";
         string paramsTypes          = "(" + getFunctionArgTypeList( function ) + ")";
+        string scriptParams         = "(" + ( function->getNumParams() > 0 ? " " + getScriptArgList( function ) + " " : "" ) + ")";
         
         // get return qualified type and function name
         string returnQualifiedType  = getFunctionQualifiedReturnType( function );
         string functionName         = getDeclarationName( function );
         string scope                = getFullScope( function->getDeclContext() );
         
+        // add the function to the model
+        FunctionRef functionModel = Object::createFunction( functionName );
+        functionModel->returnType( returnQualifiedType );
+        for( unsigned int i = 0; i < function->getNumParams(); i++ ){
+            ParmVarDecl* p = function->getParamDecl( i );
+            functionModel->addParameter( getTypeQualifiedName( p->getType() ), p->getNameAsString() );
+        }
+        mOutput.mFunctions.push_back( functionModel );
+        
+        // skip the functions the scripts never call
+        if( !mUsage.isIdentifierUsed( functionName ) ){
+            return true;
+        }
+        
+        addFunctionDependencies( function );
+        addFunctionSharedRefs( function );
+        if( function->getResultType()->isReferenceType() || function->getResultType()->isPointerType() ){
+            addEscapingType( function->getResultType() );
+        }
+        
         // change scope
         if( !scope.empty() && scope != mOutput.mCurrentFunctionScope ){
             mOutput.mFunctionDef << "\t\t" << "// set the current namespace " << endl;
@@ -930,11 +3600,35 @@ bool Parser::Visitor::VisitFunctionDecl( clang::FunctionDecl *function )
             mOutput.mCurrentFunctionScope = scope;
         }
         
-        if( !isSupported( returnQualifiedType + params + paramsTypes ) || function->getTemplatedKind() != FunctionDecl::TemplatedKind::TK_NonTemplate ){
+        // the functions using std::vector are bound through wrappers passing the vectors as views
+        bool isTemplate = function->getTemplatedKind() != FunctionDecl::TemplatedKind::TK_NonTemplate;
+        string wrapperName;
+        string wrapperDecl;
+        bool isWrapped = !isTemplate && functionName.find( "operator" ) == string::npos && writeWrapper( function, "", functionName, returnQualifiedType, &wrapperName, &wrapperDecl );
+        
+        bool isCommented = ( !isWrapped && !isSupported( returnQualifiedType + params + paramsTypes ) ) || isTemplate;
+        if( isCommented ){
             mOutput.mFunctionDef << "//";
         }
         
-        mOutput.mFunctionDef << "\t\t" << "r = engine->RegisterGlobalFunction( " << quote( returnQualifiedType + " " + functionName + params ) << ", asFUNCTIONPR( " << ( scope.empty() ? "" : scope + "::"  ) << functionName << ", " << paramsTypes << ", " << returnQualifiedType << " ), asCALL_CDECL ); assert( r >= 0 );" << endl;
+        string qualifiedFunctionName = ( scope.empty() ? "" : scope + "::"  ) + functionName;
+        string functionPtr = "asFUNCTIONPR( " + qualifiedFunctionName + ", " + paramsTypes + ", " + returnQualifiedType + " )";
+        bool isPlain = true;
+        if( isWrapped ){
+            functionPtr = "asFUNCTION( " + wrapperName + " )";
+            isPlain = false;
+        }
+        else if( mOptions.isCallCountersEnabled() && !isCommented ){
+            functionPtr = getCountedBinding( "CountedFunction", returnQualifiedType + " (*)" + paramsTypes, qualifiedFunctionName, qualifiedFunctionName + paramsTypes );
+            isPlain = false;
+        }
+        string functionDecl = quote( isWrapped ? wrapperDecl : returnQualifiedType + " " + functionName + scriptParams );
+        if( mOptions.isRegistrarEmitterEnabled() ){
+            mOutput.mFunctionDef << "\t\t" << "registrar.function( " << functionDecl << ", " << ( isPlain ? getRegistrarPointer( function, qualifiedFunctionName, returnQualifiedType + " (*)" + paramsTypes ) : functionPtr + ", asCALL_CDECL" ) << " );" << endl;
+        }
+        else {
+            mOutput.mFunctionDef << "\t\t" << "r = engine->RegisterGlobalFunction( " << functionDecl << ", " << functionPtr << ", asCALL_CDECL ); assert( r >= 0 );" << endl;
+        }
         
     }
     return true;
@@ -1111,27 +3805,60 @@ std::string Parser::Visitor::getFunctionArgList( clang::FunctionDecl *function )
     string params;
     int numParams = function->getNumParams();
     for( int i = 0; i < numParams; i++ ){
-        ParmVarDecl* p          = function->getParamDecl( i );
-        
-        // check if there's a default argument value
-        Expr* defaultArgExpr    = p->getDefaultArg();
-        string defaultArg;
-        if( defaultArgExpr ){
-            defaultArg          = declToString( defaultArgExpr );
-            // make sure with have an =
-            if( defaultArg.find( "=" ) == string::npos ){
-                defaultArg = " = " + defaultArg;
-            }
+        params                  += getFunctionArg( function->getParamDecl( i ) ) + ( i < numParams - 1 ? ", " : "" );
+    }
+    
+    return params;
+}
+//! returns the type, name and default value of an argument
+std::string Parser::Visitor::getFunctionArg( clang::ParmVarDecl *parameter )
+{
+    // check if there's a default argument value
+    Expr* defaultArgExpr    = parameter->getDefaultArg();
+    string defaultArg;
+    if( defaultArgExpr ){
+        defaultArg          = declToString( defaultArgExpr );
+        // make sure with have an =
+        if( defaultArg.find( "=" ) == string::npos ){
+            defaultArg = " = " + defaultArg;
         }
-        
-        // get argument name and type
-        string argName          = p->getNameAsString();
-        string argQualifiedType = getTypeQualifiedName( p->getType() );
-        params                  += argQualifiedType + " " + argName + defaultArg + ( i < numParams - 1 ? ", " : "" );
+    }
+    
+    // get argument name and type
+    string argName          = parameter->getNameAsString();
+    string argQualifiedType = getTypeQualifiedName( parameter->getType() );
+    return argQualifiedType + " " + argName + defaultArg;
+}
+//! returns the list of argument of a function as declared to the scripts
+std::string Parser::Visitor::getScriptArgList( clang::FunctionDecl *function )
+{
+    string params;
+    int numParams = function->getNumParams();
+    for( int i = 0; i < numParams; i++ ){
+        params                  += getScriptArg( function->getParamDecl( i ) ) + ( i < numParams - 1 ? ", " : "" );
     }
     
     return params;
 }
+//! returns an argument as declared to the scripts, strings taken by const reference are input references
+std::string Parser::Visitor::getScriptArg( clang::ParmVarDecl *parameter )
+{
+    string arg = getFunctionArg( parameter );
+    
+    // the script string or Ref is passed without being copied in a temporary
+    QualType type = parameter->getType();
+    bool isConstReference   = type->isLValueReferenceType() && type->getPointeeType().isConstQualified();
+    bool isStringReference  = isConstReference && mOptions.isStringWrappersEnabled() && isStdString( type->getPointeeType() );
+    if( isConstReference && ( isStringReference || getSharedRefRecord( type->getPointeeType() ) ) ){
+        if( isStringReference ){
+            arg = "const std::string &in" + arg.substr( getTypeQualifiedName( type ).length() );
+        }
+        else {
+            arg = getTypeQualifiedName( type ) + "in" + arg.substr( getTypeQualifiedName( type ).length() );
+        }
+    }
+    return arg;
+}
 //! returns the qualified/scoped list of argument type name of a function
 std::string Parser::Visitor::getFunctionArgTypeList( clang::FunctionDecl *function )
 {
@@ -1170,10 +3897,12 @@ std::string Parser::Visitor::getFunctionQualifiedReturnType( clang::FunctionDecl
 }
 //! returns the unique name of a declaration
 std::string Parser::Visitor::getMangleName( clang::NamedDecl *declaration ){
-    MangleContext* mangle = mContext->createMangleContext();
+    if( !mMangleContext ){
+        mMangleContext.reset( mContext->createMangleContext() );
+    }
     string name;
     llvm::raw_string_ostream stringOstream( name );
-    mangle->mangleCXXName( declaration, stringOstream );
+    mMangleContext->mangleCXXName( declaration, stringOstream );
     return stringOstream.str();
 }
 
@@ -1214,6 +3943,152 @@ std::string Parser::Visitor::quote( const std::string &declaration )
     return "\"" + declaration + "\"";
 }
 
+//! returns whether the factories keep the reference count with the object
+bool Parser::Visitor::hasIntrusiveRefCount() const
+{
+    // pooled objects need to be released by their factory so they always carry their count
+    return mOptions.isThreadSafeFactoriesEnabled() || mOptions.isPooledFactoriesEnabled();
+}
+//! returns the reference count used by the factories of that type, intrusive for the types only they create
+std::string Parser::Visitor::getRefCountedType( const std::string &qualifiedName, bool isFactoryOnly )
+{
+    string refCount = isFactoryOnly ? "RefCounted" : "RefCountMap";
+    if( mOptions.isPooledFactoriesEnabled() ){
+        return refCount + "<" + qualifiedName + ", PoolAllocator<" + ( mOptions.isThreadLocalPoolsEnabled() ? "true" : "false" ) + "> >";
+    }
+    return refCount + "<" + qualifiedName + " >";
+}
+//! records the class of a type the scripts can reach without its factory creating it
+void Parser::Visitor::addEscapingType( const clang::QualType &type )
+{
+    // a Ref hands out the object it points to
+    if( CXXRecordDecl* record = getSharedRefRecord( type ) ){
+        mOutput.mEscapingTypes.insert( getMangleName( record ) );
+        return;
+    }
+    
+    const Type* typePtr = type.getNonReferenceType().getTypePtr();
+    if( typePtr->isPointerType() ){
+        typePtr = typePtr->getPointeeType().getTypePtr();
+    }
+    if( CXXRecordDecl* recordDecl = typePtr->getAsCXXRecordDecl() ){
+        mOutput.mEscapingTypes.insert( getMangleName( recordDecl ) );
+    }
+}
+
+//! writes a call to a class registration function, wrapped in a timing probe when profiling
+void Parser::Visitor::writeRegistrationCall( std::stringstream &stream, const std::string &className, const std::string &function, const std::string &arguments )
+{
+    if( mOptions.isRegistrationProfilingEnabled() ){
+        ProfileEntry entry = { className, function };
+        stream << "\t\t" << "{ RegistrationProbe classProbe( sRegistrationProfile[" << mOutput.mProfileEntries.size() << "] ); " << function << arguments << "; }" << endl;
+        mOutput.mProfileEntries.push_back( entry );
+    }
+    else {
+        stream << "\t\t" << function << arguments << ";" << endl;
+    }
+}
+//! stores the number of registrations written to a stream since a position
+void Parser::Visitor::countRegistrations( std::stringstream &stream, std::streampos start, const std::string &function )
+{
+    if( !mOptions.isRegistrationProfilingEnabled() ){
+        return;
+    }
+    
+    // only the lines of the function are read, the stream is written again once its end is reached
+    stream.seekg( start );
+    mOutput.mRegistrationCounts[function] = Output::countRegistrationCalls( stream );
+    stream.clear();
+}
+
+//! removes the result declaration of the registration function written since a position if none of its calls assigns it
+void Parser::Visitor::removeUnusedResult( std::stringstream &stream, std::streampos start )
+{
+    // the registrar calls and the commented calls leave it unused
+    const string declaration = "\t\tint r;\n";
+    string code = stream.str();
+    size_t position = code.find( declaration, static_cast<size_t>( static_cast<streamoff>( start ) ) );
+    if( position == string::npos || assignsResult( code.substr( position + declaration.length() ) ) ){
+        return;
+    }
+    code.erase( position, declaration.length() );
+    stream.str( code );
+    stream.seekp( 0, ios::end );
+}
+
+//! returns the pointer passed to the registrar, cast to its signature if the function is overloaded
+std::string Parser::Visitor::getRegistrarPointer( clang::FunctionDecl *function, const std::string &qualifiedName, const std::string &signature )
+{
+    if( function->getDeclContext()->lookup( function->getDeclName() ).size() > 1 ){
+        return "static_cast<" + signature + ">( &" + qualifiedName + " )";
+    }
+    return "&" + qualifiedName;
+}
+
+//! returns the counting wrapper registered instead of a method or a function and adds it to the counted bindings
+std::string Parser::Visitor::getCountedBinding( const std::string &wrapper, const std::string &signature, const std::string &function, const std::string &name )
+{
+    stringstream binding;
+    binding << "asFunctionPtr( &" << wrapper << "<" << addCountedBinding( name ) << ", " << signature << ", &" << function << ">::call )";
+    return binding.str();
+}
+
+//! adds a counted binding and returns its id, an offset from the base of the header
+std::string Parser::Visitor::addCountedBinding( const std::string &name )
+{
+    string id = mOutput.mBindingIdBase + " + " + to_string( mOutput.mCountedBindings.size() );
+    mOutput.mCountedBindings.push_back( name );
+    return id;
+}
+
+//! writes a binding table and the call registering it
+void Parser::Visitor::writeBindingTable( std::stringstream &stream, std::vector<BindingTableEntry> &entries )
+{
+    // group the entries by namespace, keeping the order in which namespaces first appear
+    vector<string> namespaces;
+    for( auto entry : entries ){
+        if( find( namespaces.begin(), namespaces.end(), entry.mNamespace ) == namespaces.end() ){
+            namespaces.push_back( entry.mNamespace );
+        }
+    }
+    stable_sort( entries.begin(), entries.end(), [&namespaces]( const BindingTableEntry &a, const BindingTableEntry &b ){
+        return find( namespaces.begin(), namespaces.end(), a.mNamespace ) < find( namespaces.begin(), namespaces.end(), b.mNamespace );
+    } );
+    
+    size_t numEntries = count_if( entries.begin(), entries.end(), []( const BindingTableEntry &entry ){ return !entry.mIsCommented; } );
+    
+    // unsupported entries only appear as comments
+    if( numEntries == 0 ){
+        for( auto entry : entries ){
+            stream << "\t\t" << "// " << entry.mDeclaration << endl;
+        }
+        return;
+    }
+    
+    stream << "\t\t" << "static const BindingEntry sEntries[] = {" << endl;
+    for( auto entry : entries ){
+        if( entry.mIsCommented ){
+            stream << "//\t\t\t" << entry.mDeclaration << endl;
+            continue;
+        }
+        stream << "\t\t\t" << "{ BindingEntry::" << entry.mKind << ", " << entry.mCallConv << ", " << entry.mBehaviour << ", ";
+        stream << mOutput.getBindingStringIndex( entry.mNamespace ) << ", " << mOutput.getBindingStringIndex( entry.mObject ) << ", " << mOutput.getBindingStringIndex( entry.mDeclaration ) << " }, ";
+        stream << "// " << entry.mDeclaration << endl;
+    }
+    stream << "\t\t" << "};" << endl;
+    
+    // function pointers can't be constant expressions so they are initialized on the first registration
+    stream << "\t\t" << "static const asSFuncPtr sFunctions[] = {" << endl;
+    for( auto entry : entries ){
+        if( !entry.mIsCommented ){
+            stream << "\t\t\t" << entry.mFunction << "," << endl;
+        }
+    }
+    stream << "\t\t" << "};" << endl;
+    stream << endl;
+    stream << "\t\t" << "registerBindingTable( engine, sBindingStrings, sEntries, sFunctions, " << numEntries << " );" << endl;
+}
+
 clang::DeclContext* Parser::Visitor::getTypeDeclContext( const clang::QualType& type )
 {
     DeclContext* context = nullptr;
@@ -1239,12 +4114,473 @@ clang::DeclContext* Parser::Visitor::getTypeDeclContext( const clang::QualType&
     return context;
 }
 
+//! records the header declaring a type if it's not the main file
+void Parser::Visitor::addTypeDependency( const clang::QualType& type )
+{
+    const Type* typePtr = type.getNonReferenceType().getTypePtr();
+    if( typePtr->isPointerType() ){
+        typePtr = typePtr->getPointeeType().getTypePtr();
+    }
+    
+    Decl* declaration = nullptr;
+    if( const TypedefType* typedefType = typePtr->getAs<TypedefType>() ){
+        declaration = typedefType->getDecl();
+    }
+    else if( CXXRecordDecl* recordDecl = typePtr->getAsCXXRecordDecl() ){
+        declaration = recordDecl;
+    }
+    else if( const EnumType* enumType = typePtr->getAs<EnumType>() ){
+        declaration = enumType->getDecl();
+    }
+    
+    if( declaration != nullptr ){
+        SourceManager &sourceManager    = mContext->getSourceManager();
+        SourceLocation location         = sourceManager.getSpellingLoc( declaration->getLocation() );
+        if( location.isValid() && !sourceManager.isInMainFile( location ) ){
+            if( const FileEntry* file = sourceManager.getFileEntryForID( sourceManager.getFileID( location ) ) ){
+                mOutput.mDependencies.insert( file->getName() );
+            }
+        }
+    }
+}
+//! records the headers declaring the return and parameter types of a function
+void Parser::Visitor::addFunctionDependencies( clang::FunctionDecl *function )
+{
+    addTypeDependency( function->getResultType() );
+    for( unsigned int i = 0; i < function->getNumParams(); i++ ){
+        addTypeDependency( function->getParamDecl( i )->getType() );
+    }
+}
+
+
+//! returns the field of the class a method returns or assigns if its body does nothing else
+clang::FieldDecl* Parser::Visitor::getTrivialAccessorField( clang::CXXMethodDecl *method, bool *isSetter )
+{
+    // only the bodies visible from the header can be inspected
+    CompoundStmt* body = llvm::dyn_cast_or_null<CompoundStmt>( method->getBody() );
+    if( !body || body->size() != 1 ){
+        return nullptr;
+    }
+    
+    // strips the implicit casts, temporaries and copies around an expression
+    auto strip = []( Expr* expr ){
+        while( expr ){
+            expr = expr->IgnoreParenImpCasts();
+            if( ExprWithCleanups* cleanups = llvm::dyn_cast<ExprWithCleanups>( expr ) ){
+                expr = cleanups->getSubExpr();
+            }
+            else if( MaterializeTemporaryExpr* temporary = llvm::dyn_cast<MaterializeTemporaryExpr>( expr ) ){
+                expr = temporary->GetTemporaryExpr();
+            }
+            else if( CXXConstructExpr* construct = llvm::dyn_cast<CXXConstructExpr>( expr ) ){
+                if( construct->getNumArgs() != 1 || !construct->getConstructor()->isCopyOrMoveConstructor() ){
+                    break;
+                }
+                expr = construct->getArg( 0 );
+            }
+            else break;
+        }
+        return expr;
+    };
+    // returns the field of the class if the expression is this->field
+    auto getField = [&]( Expr* expr ) -> FieldDecl* {
+        MemberExpr* member = llvm::dyn_cast_or_null<MemberExpr>( strip( expr ) );
+        if( !member || !llvm::isa<CXXThisExpr>( member->getBase()->IgnoreParenImpCasts() ) ){
+            return nullptr;
+        }
+        FieldDecl* field = llvm::dyn_cast<FieldDecl>( member->getMemberDecl() );
+        return field && field->getParent() == method->getParent() ? field : nullptr;
+    };
+    
+    Stmt* statement = body->body_back();
+    
+    // return field;
+    if( ReturnStmt* returnStmt = llvm::dyn_cast<ReturnStmt>( statement ) ){
+        if( method->getNumParams() == 0 && !method->getResultType()->isVoidType() ){
+            *isSetter = false;
+            return getField( returnStmt->getRetValue() );
+        }
+        return nullptr;
+    }
+    
+    // field = parameter;
+    if( method->getNumParams() != 1 || !method->getResultType()->isVoidType() ){
+        return nullptr;
+    }
+    Expr* lhs = nullptr;
+    Expr* rhs = nullptr;
+    if( BinaryOperator* assign = llvm::dyn_cast<BinaryOperator>( statement ) ){
+        if( assign->getOpcode() == BO_Assign ){
+            lhs = assign->getLHS();
+            rhs = assign->getRHS();
+        }
+    }
+    else if( CXXOperatorCallExpr* assign = llvm::dyn_cast<CXXOperatorCallExpr>( statement ) ){
+        if( assign->getOperator() == OO_Equal && assign->getNumArgs() == 2 ){
+            lhs = assign->getArg( 0 );
+            rhs = assign->getArg( 1 );
+        }
+    }
+    DeclRefExpr* parameter = llvm::dyn_cast_or_null<DeclRefExpr>( strip( rhs ) );
+    if( !parameter || parameter->getDecl() != method->getParamDecl( 0 ) ){
+        return nullptr;
+    }
+    *isSetter = true;
+    return getField( lhs );
+}
+//! returns the property name of an accessor, getR and setR give r, or an empty string
+std::string Parser::Visitor::getAccessorPropertyName( const std::string &methodName, bool isSetter )
+{
+    string prefix = isSetter ? "set" : ( methodName.find( "is" ) == 0 ? "is" : "get" );
+    if( methodName.find( prefix ) != 0 || methodName.length() == prefix.length() || !isupper( static_cast<unsigned char>( methodName[prefix.length()] ) ) ){
+        return "";
+    }
+    
+    // lower the first letter, or the whole name of an acronym like getRGB
+    string propertyName = methodName.substr( prefix.length() );
+    bool isAcronym = all_of( propertyName.begin(), propertyName.end(), []( char c ){ return isupper( static_cast<unsigned char>( c ) ) || isdigit( static_cast<unsigned char>( c ) ); } );
+    for( size_t i = 0; i < ( isAcronym ? propertyName.length() : 1 ); i++ ){
+        propertyName[i] = tolower( static_cast<unsigned char>( propertyName[i] ) );
+    }
+    return propertyName;
+}
+
+//! returns the class a Ref typedef of a bound header points to, or null if the type isn't one
+clang::CXXRecordDecl* Parser::Visitor::getSharedRefRecord( const clang::QualType &type )
+{
+    const TypedefType* typedefType = type.getNonReferenceType()->getAs<TypedefType>();
+    if( !typedefType ){
+        return nullptr;
+    }
+    
+    const ClassTemplateSpecializationDecl* specialization = llvm::dyn_cast_or_null<ClassTemplateSpecializationDecl>( typedefType->desugar().getCanonicalType()->getAsCXXRecordDecl() );
+    if( !specialization || specialization->getName() != "shared_ptr" || !specialization->getDeclContext()->isStdNamespace() ){
+        return nullptr;
+    }
+    const TemplateArgumentList &arguments = specialization->getTemplateArgs();
+    if( arguments.size() == 0 || arguments[0].getKind() != TemplateArgument::Type ){
+        return nullptr;
+    }
+    CXXRecordDecl* record = arguments[0].getAsType()->getAsCXXRecordDecl();
+    if( !record || !record->hasDefinition() || record->isDependentContext() ){
+        return nullptr;
+    }
+    
+    // the Ref is only registered by the header declaring it, so it has to be one of the bound headers
+    SourceManager &sourceManager    = mContext->getSourceManager();
+    SourceLocation location         = sourceManager.getSpellingLoc( typedefType->getDecl()->getLocation() );
+    if( !location.isValid() ){
+        return nullptr;
+    }
+    if( !sourceManager.isInMainFile( location ) ){
+        const FileEntry* file = sourceManager.getFileEntryForID( sourceManager.getFileID( location ) );
+        boost::system::error_code error;
+        fs::path path = file ? fs::canonical( file->getName(), error ) : fs::path();
+        fs::path inputDirectory = fs::canonical( mOptions.getInputDirectory(), error );
+        if( path.empty() || error || !boost::starts_with( path.string(), inputDirectory.string() ) ){
+            return nullptr;
+        }
+    }
+    return record;
+}
+//! returns whether the header declaring a Ref typedef registers it, only the used typedefs outside of the classes are
+bool Parser::Visitor::isSharedRefRegistered( clang::TypedefNameDecl *declaration )
+{
+    return getFullScope( declaration->getDeclContext() ).empty() && mUsage.isTypeUsed( declaration->getNameAsString() );
+}
+//! marks the Ref typedef of a type as supported if its header registers it, by its name and its qualified names
+void Parser::Visitor::addSharedRef( const clang::QualType &type )
+{
+    if( getSharedRefRecord( type ) ){
+        TypedefNameDecl* declaration = type.getNonReferenceType()->getAs<TypedefType>()->getDecl();
+        if( isSharedRefRegistered( declaration ) ){
+            string qualifiedName = getDeclarationQualifiedName( declaration );
+            mSharedRefNames.insert( declaration->getNameAsString() );
+            mSharedRefNames.insert( qualifiedName );
+            mSharedRefNames.insert( replaceNamespacesByAliases( qualifiedName ) );
+        }
+    }
+}
+//! marks the Ref typedefs used by the return and parameter types of a function as supported
+void Parser::Visitor::addFunctionSharedRefs( clang::FunctionDecl *function )
+{
+    addSharedRef( function->getResultType() );
+    for( unsigned int i = 0; i < function->getNumParams(); i++ ){
+        addSharedRef( function->getParamDecl( i )->getType() );
+    }
+}
+
+//! returns whether a type is a std::string, ignoring its qualifiers
+bool Parser::Visitor::isStdString( const clang::QualType &type )
+{
+    const ClassTemplateSpecializationDecl* specialization = llvm::dyn_cast_or_null<ClassTemplateSpecializationDecl>( type.getCanonicalType()->getAsCXXRecordDecl() );
+    if( !specialization || specialization->getName() != "basic_string" || !specialization->getDeclContext()->isStdNamespace() ){
+        return false;
+    }
+    const TemplateArgumentList &arguments = specialization->getTemplateArgs();
+    return arguments.size() > 0 && arguments[0].getKind() == TemplateArgument::Type && arguments[0].getAsType()->isCharType();
+}
+//! returns whether a type is a const char pointer
+bool Parser::Visitor::isCString( const clang::QualType &type )
+{
+    const PointerType* pointer = type.getCanonicalType()->getAs<PointerType>();
+    return pointer && pointer->getPointeeType().isConstQualified() && pointer->getPointeeType()->isCharType();
+}
+//! returns the element type of a std::vector passed by value or const reference, or a null type
+clang::QualType Parser::Visitor::getVectorElementType( const clang::QualType &type, bool *isConstReference )
+{
+    QualType valueType  = type;
+    *isConstReference   = false;
+    if( const LValueReferenceType* reference = type->getAs<LValueReferenceType>() ){
+        valueType = reference->getPointeeType();
+        if( !valueType.isConstQualified() ){
+            return QualType();
+        }
+        *isConstReference = true;
+    }
+    
+    ClassTemplateSpecializationDecl* specialization = llvm::dyn_cast_or_null<ClassTemplateSpecializationDecl>( valueType->getAsCXXRecordDecl() );
+    if( !specialization || specialization->getName() != "vector" || !specialization->getDeclContext()->isStdNamespace() ){
+        return QualType();
+    }
+    
+    // prefer the element type as written so typedefs like Vec2f keep their name
+    if( const TemplateSpecializationType* written = valueType->getAs<TemplateSpecializationType>() ){
+        if( written->getNumArgs() > 0 && written->getArg( 0 ).getKind() == TemplateArgument::Type ){
+            return written->getArg( 0 ).getAsType();
+        }
+    }
+    const TemplateArgumentList &arguments = specialization->getTemplateArgs();
+    if( arguments.size() == 0 || arguments[0].getKind() != TemplateArgument::Type ){
+        return QualType();
+    }
+    return arguments[0].getAsType();
+}
+//! returns the script name of the view of a vector element type and adds it to the views, or an empty string if it can't be viewed
+std::string Parser::Visitor::getVectorViewType( const clang::QualType &elementType, std::map<std::string,std::pair<std::string,std::string>> *views )
+{
+    // vector<bool> has no storage to point to, and intrusively counted objects can't live in a vector
+    const Type* element = elementType.getTypePtr();
+    if( element->isBooleanType() || element->isPointerType() || element->isReferenceType() || element->isDependentType() ){
+        return "";
+    }
+    if( !element->isArithmeticType() && !element->isRecordType() ){
+        return "";
+    }
+    if( element->isRecordType() && hasIntrusiveRefCount() ){
+        return "";
+    }
+    
+    string qualifiedName = getTypeQualifiedName( elementType.getUnqualifiedType() );
+    if( !isSupported( qualifiedName ) ){
+        return "";
+    }
+    string scriptName = qualifiedName;
+    boost::replace_all( scriptName, "std::string", "string" );
+    if( element->isArithmeticType() ){
+        scriptName = getScriptArithmeticType( elementType );
+        if( scriptName.empty() ){
+            return "";
+        }
+    }
+    
+    // the view is named after the unscoped element type
+    clang::LangOptions langOpts;
+    langOpts.CPlusPlus = true;
+    clang::PrintingPolicy printingPolicy( langOpts );
+    printingPolicy.SuppressTagKeyword = true;
+    printingPolicy.SuppressScope = true;
+    printingPolicy.Bool = true;
+    string name = elementType.getUnqualifiedType().getAsString( printingPolicy );
+    name.erase( remove_if( name.begin(), name.end(), []( char c ){ return !isalnum( static_cast<unsigned char>( c ) ); } ), name.end() );
+    if( name.empty() ){
+        return "";
+    }
+    name[0] = toupper( static_cast<unsigned char>( name[0] ) );
+    name += "Vector";
+    
+    (*views)[name] = make_pair( qualifiedName, scriptName );
+    return name;
+}
+//! returns the script name of an arithmetic type, int8 to uint64, float or double, or an empty string if the scripts have none
+std::string Parser::Visitor::getScriptArithmeticType( const clang::QualType &type )
+{
+    const BuiltinType* builtin = type.getCanonicalType()->getAs<BuiltinType>();
+    if( !builtin ){
+        return "";
+    }
+    if( builtin->getKind() == BuiltinType::Float ){
+        return "float";
+    }
+    if( builtin->getKind() == BuiltinType::Double ){
+        return "double";
+    }
+    if( !builtin->isInteger() || builtin->getKind() == BuiltinType::Bool ){
+        return "";
+    }
+    
+    // the integers are named after their size, the script int and uint are 32 bits wide
+    uint64_t bits = mContext->getTypeSize( type );
+    string name = builtin->isSignedInteger() ? "int" : "uint";
+    if( bits == 32 ){
+        return name;
+    }
+    if( bits == 8 || bits == 16 || bits == 64 ){
+        return name + to_string( bits );
+    }
+    return "";
+}
+//! writes a wrapper passing the std::vector arguments and return value of a function as views and its
+//! string arguments by reference, returns false if the function doesn't need one or can't have one
+bool Parser::Visitor::writeWrapper( clang::FunctionDecl *function, const std::string &factory, const std::string &name, const std::string &returnType, std::string *wrapperName, std::string *declaration )
+{
+    if( function->isDependentContext() ){
+        return false;
+    }
+    
+    CXXMethodDecl* method       = llvm::dyn_cast<CXXMethodDecl>( function );
+    bool hasObject              = method && !method->isStatic();
+    string functionName         = getDeclarationQualifiedName( function );
+    string objectType           = hasObject ? getDeclarationQualifiedName( method->getParent() ) : "";
+    bool needsWrapper           = false;
+    map<string,pair<string,string>> views;
+    
+    // pass the views as const references to the vectors they point to and the script strings by reference
+    vector<string> wrapperParams;
+    vector<string> callArgs;
+    vector<string> scriptParams;
+    if( hasObject ){
+        wrapperParams.push_back( ( method->isConst() ? "const " : "" ) + objectType + " *object" );
+    }
+    for( unsigned int i = 0; i < function->getNumParams(); i++ ){
+        ParmVarDecl* p      = function->getParamDecl( i );
+        string argName      = p->getNameAsString().empty() ? "arg" + to_string( i ) : p->getNameAsString();
+        bool isConstRef     = false;
+        QualType element    = mOptions.isVectorViewsEnabled() ? getVectorElementType( p->getType(), &isConstRef ) : QualType();
+        if( !element.isNull() ){
+            // a vector taken by value would be copied anyway
+            string view = isConstRef ? getVectorViewType( element, &views ) : "";
+            if( view.empty() ){
+                return false;
+            }
+            wrapperParams.push_back( "const VectorView<" + getTypeQualifiedName( element.getUnqualifiedType() ) + " > &" + argName );
+            callArgs.push_back( argName + ".get()" );
+            scriptParams.push_back( "const " + view + " &in " + argName );
+            needsWrapper = true;
+        }
+        else if( mOptions.isStringWrappersEnabled() && ( isStdString( p->getType() ) || isCString( p->getType() ) ) ){
+            // a C string points in the script string storage, only a string literal default value can be kept
+            Expr* defaultArg = p->getDefaultArg();
+            if( defaultArg && !llvm::isa<StringLiteral>( defaultArg->IgnoreParenImpCasts() ) && isCString( p->getType() ) ){
+                return false;
+            }
+            wrapperParams.push_back( "const std::string &" + argName );
+            callArgs.push_back( isCString( p->getType() ) ? argName + ".c_str()" : argName );
+            scriptParams.push_back( "const std::string &in" + getFunctionArg( p ).substr( getTypeQualifiedName( p->getType() ).length() ) );
+            needsWrapper = true;
+        }
+        else {
+            wrapperParams.push_back( getTypeQualifiedName( p->getType() ) + " " + argName );
+            callArgs.push_back( argName );
+            scriptParams.push_back( getScriptArg( p ) );
+        }
+    }
+    
+    string call = ( hasObject ? "object->" + function->getNameAsString() : functionName ) + "( " + boost::algorithm::join( callArgs, ", " ) + ( callArgs.empty() ? ")" : " )" );
+    
+    // a vector returned by value moves in the view, a vector returned by reference is viewed while its owner is kept alive
+    bool isConstRef             = false;
+    QualType returnElement      = mOptions.isVectorViewsEnabled() ? getVectorElementType( function->getResultType(), &isConstRef ) : QualType();
+    string wrapperReturnType    = getTypeQualifiedName( function->getResultType() );
+    string scriptReturnType     = returnType;
+    stringstream body;
+    if( !returnElement.isNull() ){
+        string view = getVectorViewType( returnElement, &views );
+        // the map factory never destroys anything so it can't keep the owner alive, those methods aren't wrapped rather than copying the vector
+        if( view.empty() || ( isConstRef && hasObject && ( factory.empty() || !hasIntrusiveRefCount() ) ) ){
+            return false;
+        }
+        string viewType     = "VectorView<" + getTypeQualifiedName( returnElement.getUnqualifiedType() ) + " >";
+        wrapperReturnType   = viewType + "*";
+        scriptReturnType    = ( isConstRef ? "const " : "" ) + view + "@";
+        if( !isConstRef ){
+            body << "		" << "return " << viewType << "::create( " << call << " );" << endl;
+        }
+        else if( hasObject ){
+            // the counts of the factory own the objects it created, the view holds a reference like a script handle
+            body << "		" << objectType << "* owner = const_cast<" << objectType << "*>( object );" << endl;
+            body << "		" << factory << "::addRef( owner );" << endl;
+            body << "		" << "return " << viewType << "::createView( " << call << ", owner, []( void* owner ){ " << factory << "::release( static_cast<" << objectType << "*>( owner ) ); } );" << endl;
+        }
+        else {
+            body << "		" << "return " << viewType << "::createView( " << call << ", nullptr, nullptr );" << endl;
+        }
+        needsWrapper = true;
+    }
+    else {
+        body << "		" << ( function->getResultType()->isVoidType() ? "" : "return " ) << call << ";" << endl;
+    }
+    
+    if( !needsWrapper ){
+        return false;
+    }
+    
+    // the other types of the function can still be unsupported
+    *declaration = scriptReturnType + " " + name + "(" + ( scriptParams.empty() ? "" : " " + boost::algorithm::join( scriptParams, ", " ) + " " ) + ")" + ( method && method->isConst() ? " const" : "" );
+    boost::replace_all( *declaration, "std::string", "string" );
+    if( !isSupported( *declaration ) ){
+        return false;
+    }
+    mOutput.mVectorViews.insert( views.begin(), views.end() );
+    
+    // overloads get their own wrapper
+    *wrapperName = styleScopedName( functionName ) + "Wrapper";
+    for( size_t i = 1; mOutput.mWrappersNames.count( *wrapperName ); i++ ){
+        *wrapperName = styleScopedName( functionName ) + "Wrapper" + to_string( i );
+    }
+    mOutput.mWrappersNames.insert( *wrapperName );
+    
+    mOutput.mWrappers << "	" << "//! " << functionName << " wrapper passing its " << ( views.empty() ? "strings by reference" : "vectors as views" ) << endl;
+    mOutput.mWrappers << "	" << "static " << wrapperReturnType << " " << *wrapperName << "( " << boost::algorithm::join( wrapperParams, ", " ) << " )" << endl;
+    mOutput.mWrappers << "	" << "{" << endl;
+    
+    // the wrapper is registered in place of the function so it counts the calls like the counting templates
+    if( mOptions.isCallCountersEnabled() ){
+        string id = addCountedBinding( functionName + "(" + getFunctionArgTypeList( function ) + ")" + ( method && method->isConst() ? " const" : "" ) );
+        mOutput.mWrappers << "		" << "sBindingCallCounts[" << id << "].fetch_add( 1, std::memory_order_relaxed );" << endl;
+    }
+    mOutput.mWrappers << body.str();
+    mOutput.mWrappers << "	" << "}" << endl;
+    
+    return true;
+}
 
 bool Parser::Visitor::isSupported( const std::string& expr )
 {
+    // the Ref typedefs bound as value types are supported even if they match an unsupported type,
+    // only the whole identifiers naming one of them are left out
+    string supportedExpr;
+    size_t length = expr.length();
+    size_t i = 0;
+    while( i < length ){
+        size_t end = i;
+        while( end < length && ( isalnum( static_cast<unsigned char>( expr[end] ) ) || expr[end] == '_' || expr.compare( end, 2, "::" ) == 0 ) ){
+            end += expr.compare( end, 2, "::" ) == 0 ? 2 : 1;
+        }
+        if( end == i ){
+            supportedExpr += expr[i++];
+            continue;
+        }
+        string identifier = expr.substr( i, end - i );
+        if( !mSharedRefNames.count( identifier ) ){
+            supportedExpr += identifier;
+        }
+        i = end;
+    }
+    
     const vector<string> &unsupported = mOptions.getUnsupportedTypes();
     for( vector<string>::const_iterator it = unsupported.begin(); it != unsupported.end(); ++it ){
-        if( expr.find( *it ) != string::npos ){
+        if( supportedExpr.find( *it ) != string::npos ){
             return false;
         }
     }
@@ -1280,7 +4616,24 @@ void Parser::Consumer::HandleTranslationUnit( ASTContext &context ) {
     
     /* we can use ASTContext to get the TranslationUnitDecl, which is
      a single Decl that collectively represents the entire source file */
-    mVisitor.TraverseDecl( context.getTranslationUnitDecl() );
+    if( mOutput.mTrace ){
+        mOutput.mTrace->add( "preprocess and parse", "clang", mOutput.mParseStart, Trace::now() - mOutput.mParseStart );
+    }
+    
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    {
+        TraceSpan span( mOutput.mTrace, "traversal", "visit" );
+        mVisitor.TraverseDecl( context.getTranslationUnitDecl() );
+    }
+    mOutput.mVisitTime = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+    
+    // the allocators are still alive, they are released with the compiler instance
+    SourceManager::MemoryBufferSizes buffers    = context.getSourceManager().getMemoryBufferSizes();
+    mOutput.mMemory.mAstBytes                   = context.getASTAllocatedMemory();
+    mOutput.mMemory.mSideTableBytes             = context.getSideTableAllocatedMemory();
+    mOutput.mMemory.mSourceMallocBytes          = buffers.malloc_bytes;
+    mOutput.mMemory.mSourceMmapBytes            = buffers.mmap_bytes;
+    mOutput.mMemory.mSourceTableBytes           = context.getSourceManager().getDataStructureSizes() + context.getSourceManager().getContentCacheSize();
 }
 
 
@@ -1302,16 +4655,29 @@ void Parser::PreprocessorParser::InclusionDirective( clang::SourceLocation HashL
                                                     clang::StringRef RelativePath,
                                                     const clang::Module *Imported)
 {
-    if( mContext->getSourceManager().isInMainFile( mContext->getFullLoc( HashLoc ) ) ){
-        
-       // mOutput.mClassImpls << "#include " << ( IsAngled ? "<" : "\"" ) << RelativePath.str() << ( IsAngled ? ">" : "\"" ) << endl;
+    SourceManager &sourceManager = mContext->getSourceManager();
+    
+    // keep the edge for the incremental runs, the parsed header is in memory so it has no file entry
+    IncludeEdge edge;
+    if( !sourceManager.isInMainFile( mContext->getFullLoc( HashLoc ) ) ){
+        const FileEntry* includer = sourceManager.getFileEntryForID( sourceManager.getFileID( sourceManager.getExpansionLoc( HashLoc ) ) );
+        if( !includer ){
+            return;
+        }
+        edge.mIncluder = includer->getName();
     }
+    edge.mIncluded  = FileName.str();
+    edge.mPath      = File ? File->getName() : "";
+    mOutput.mIncludes.push_back( edge );
 }
 
     //! returns our writter consumer
 clang::ASTConsumer * Parser::FrontendAction::CreateASTConsumer( clang::CompilerInstance &compiler, clang::StringRef file )
 {
+    // the preprocessor runs along the parser, both are traced by the same span
+    mOutput.mParseStart = Trace::now();
+    
     Preprocessor& pp = compiler.getPreprocessor();
     pp.addPPCallbacks( new PreprocessorParser( &compiler.getASTContext(), mOutput ) );
-    return new Consumer( &compiler.getASTContext(), mOutput, mOptions );
+    return new Consumer( &compiler.getASTContext(), mOutput, mOptions, mUsage );
 }
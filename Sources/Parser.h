@@ -21,13 +21,19 @@
 #include "clang/Lex/Preprocessor.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "clang/Basic/FileManager.h"
 
 
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <ctime>
+
+#include <boost/filesystem/path.hpp>
 
 
 typedef std::shared_ptr<class Object>   ObjectRef;
@@ -46,7 +52,7 @@ public:
     static MethodRef    createMethod( const std::string &name );
     
     //! creates and returns an empty named object
-    Object( const std::string &name ) : mName( name ) {}
+    Object( const std::string &name ) : mName( name ), mIsConst( false ), mIsTemplate( false ) {}
     
     //! sets the name and returns the object
     Object& name( const std::string &name ) { mName = name; return *this; }
@@ -134,14 +140,19 @@ public:
     
     //! sets whether the field is static
     Field& statical( bool isStatic = true ) { mIsStatic = isStatic; return *this; }
+    //! sets the field type
+    Field& type( const std::string &type ) { mType = type; return *this; }
     
     //! returns whether the field is static
     bool isStatic() const { return mIsStatic; }
+    //! returns the field type
+    std::string getType() const { return mType; }
     //! returns the object kind
     std::string getKind() const { return "Field"; }
     
 protected:
-    bool mIsStatic;
+    std::string mType;
+    bool        mIsStatic;
 };
 
 class Method : public Function {
@@ -190,10 +201,13 @@ public:
     
     class Options {
     public:
+        Options() : mTableRegistration( false ), mRegistrationUnits( false ), mThreadSafeFactories( false ), mPooledFactories( false ), mThreadLocalPools( false ), mRegistrationProfiling( false ), mCallCounters( false ), mAccessorProperties( false ), mVectorViews( false ), mStringWrappers( true ), mRegistrarEmitter( false ), mIncremental( false ), mDepfiles( false ), mShardIndex( 0 ), mShardCount( 1 ), mMerge( false ), mWorkers( 0 ), mWorkerJobs( 64 ), mWorkerMemoryLimit( 0 ), mWorkerTimeout( 0 ), mPrefilter( true ), mTrace( false ), mMemoryReport( 0 ) {}
         
         Options& outputDirectory( const std::string& path ){ mOutputDirectory = path; return *this; }
         Options& inputDirectory( const std::string& path ){ mInputDirectory = path; return *this; }
         Options& license( const std::string& license ){ mLicense = license; return *this; }
+        //! only emits the bindings reachable from the identifiers used by the .as scripts of that directory
+        Options& scriptDirectory( const std::string& path ){ mScriptDirectory = path; return *this; }
         
         Options& inputFileList( const std::vector<std::string>& list ){ mInputFileList = list; return *this; }
         Options& excludeFileList( const std::vector<std::string>& list ){ mExcludeFileList = list; return *this; }
@@ -201,10 +215,59 @@ public:
         Options& compilerFlags( const std::vector<std::string>& flags ){ mCompilerFlags = flags; return *this; }
         Options& unsupportedTypes( const std::vector<std::string>& types ){ mUnsupportedTypes = types; return *this; }
         Options& supportedOperators( const std::map<std::string,std::string>& operators ){ mSupportedOperators = operators; return *this; }
+        //! emits class methods as static descriptor tables registered by a single loop instead of unrolled calls
+        Options& tableRegistration( bool enabled = true ){ mTableRegistration = enabled; return *this; }
+        //! writes a table of per-header registration units and their dependencies so hosts can register only what a script needs
+        Options& registrationUnits( bool enabled = true ){ mRegistrationUnits = enabled; return *this; }
+        //! emits factories storing an atomic reference count with each object the scripts only get from them, the others are counted in a locked map
+        Options& threadSafeFactories( bool enabled = true ){ mThreadSafeFactories = enabled; return *this; }
+        //! allocates the objects created by the factories from size class free-lists, implies intrusive reference counts
+        Options& pooledFactories( bool enabled = true ){ mPooledFactories = enabled; return *this; }
+        //! gives each thread its own pools free-lists so allocations never take a lock
+        Options& threadLocalPools( bool enabled = true ){ mThreadLocalPools = enabled; return *this; }
+        //! wraps the registration functions in timing probes reported by as::getRegistrationProfile()
+        Options& registrationProfiling( bool enabled = true ){ mRegistrationProfiling = enabled; return *this; }
+        //! registers counting wrappers instead of the methods and functions so scripts hot bindings can be listed
+        Options& callCounters( bool enabled = true ){ mCallCounters = enabled; return *this; }
+        //! registers the getters and setters that only return or assign a field as script properties, the
+        //! templates like ColorT or Vec2 register them with their methods for every registered specialization
+        Options& accessorProperties( bool enabled = true ){ mAccessorProperties = enabled; return *this; }
+        //! binds the functions taking or returning std::vector through wrappers exposing the vectors as script views,
+        //! even if std::vector is one of the unsupported types
+        Options& vectorViews( bool enabled = true ){ mVectorViews = enabled; return *this; }
+        //! declares the strings taken by const reference as script input references and binds the functions taking
+        //! strings or C strings by value through wrappers reading the script string, so the calls don't copy them
+        Options& stringWrappers( bool enabled = true ){ mStringWrappers = enabled; return *this; }
+        //! emits the methods and functions as as::Registrar calls deducing their pointer and calling convention at compile time
+        Options& registrarEmitter( bool enabled = true ){ mRegistrarEmitter = enabled; return *this; }
+        //! keeps the include graph between runs and only parses again the headers including a changed file
+        Options& incremental( bool enabled = true ){ mIncremental = enabled; return *this; }
+        //! writes a Makefile / Ninja depfile next to every generated header and one for the whole run
+        Options& depfiles( bool enabled = true ){ mDepfiles = enabled; return *this; }
+        //! only parses the part index of count of the headers and keeps their records for the merge step
+        Options& shard( size_t index, size_t count ){ mShardIndex = index; mShardCount = count; return *this; }
+        //! writes the shared files and the registry from the records of every shard
+        Options& merge( bool enabled = true ){ mMerge = enabled; return *this; }
+        //! parses the headers in forked worker processes that send the headers bindings back to be emitted, 0 parses them in process
+        //! the times of the headers are kept in CinderTimings.txt so the next runs start the costliest headers first
+        Options& workers( size_t count ){ mWorkers = count; return *this; }
+        //! recycles a worker after a number of headers, 0 never recycles it
+        Options& workerJobs( size_t jobs ){ mWorkerJobs = jobs; return *this; }
+        //! recycles a worker once its resident memory passes the limit, its allocations fail past twice the limit
+        Options& workerMemoryLimit( size_t megabytes ){ mWorkerMemoryLimit = megabytes; return *this; }
+        //! kills a worker parsing a header for longer than the timeout
+        Options& workerTimeout( double seconds ){ mWorkerTimeout = seconds; return *this; }
+        //! skips the headers without class, enum, function or typedef declarations of their own before parsing them
+        Options& prefilter( bool enabled = true ){ mPrefilter = enabled; return *this; }
+        //! records the phases of every header in a chrome trace, CinderTrace.json, and prints a summary of the run
+        Options& trace( bool enabled = true ){ mTrace = enabled; return *this; }
+        //! measures the memory used by every header and prints the most memory hungry ones, 0 disables the report
+        Options& memoryReport( size_t topHeaders = 10 ){ mMemoryReport = topHeaders; return *this; }
         
         std::string getOutputDirectory() const { return mOutputDirectory; }
         std::string getInputDirectory() const { return mInputDirectory; }
         std::string getLicense() const { return mLicense; }
+        std::string getScriptDirectory() const { return mScriptDirectory; }
         
         const std::vector<std::string>& getInputFileList() const { return mInputFileList; }
         const std::vector<std::string>& getExcludeFileList() const { return mExcludeFileList; }
@@ -212,11 +275,37 @@ public:
         const std::vector<std::string>& getCompilerFlags() const { return mCompilerFlags; }
         const std::vector<std::string>& getUnsupportedTypes() const { return mUnsupportedTypes; }
         const std::map<std::string,std::string>& getSupportedOperators() const { return mSupportedOperators; }
+        bool isTableRegistrationEnabled() const { return mTableRegistration; }
+        bool isRegistrationUnitsEnabled() const { return mRegistrationUnits; }
+        bool isThreadSafeFactoriesEnabled() const { return mThreadSafeFactories; }
+        bool isPooledFactoriesEnabled() const { return mPooledFactories; }
+        bool isThreadLocalPoolsEnabled() const { return mThreadLocalPools; }
+        bool isRegistrationProfilingEnabled() const { return mRegistrationProfiling; }
+        bool isCallCountersEnabled() const { return mCallCounters; }
+        bool isAccessorPropertiesEnabled() const { return mAccessorProperties; }
+        bool isVectorViewsEnabled() const { return mVectorViews; }
+        bool isStringWrappersEnabled() const { return mStringWrappers; }
+        bool isRegistrarEmitterEnabled() const { return mRegistrarEmitter; }
+        bool isIncrementalEnabled() const { return mIncremental; }
+        bool isDepfilesEnabled() const { return mDepfiles; }
+        bool isSharded() const { return mShardCount > 1; }
+        size_t getShardIndex() const { return mShardIndex; }
+        size_t getShardCount() const { return mShardCount; }
+        bool isMergeEnabled() const { return mMerge; }
+        size_t getWorkers() const { return mWorkers; }
+        size_t getWorkerJobs() const { return mWorkerJobs; }
+        size_t getWorkerMemoryLimit() const { return mWorkerMemoryLimit; }
+        double getWorkerTimeout() const { return mWorkerTimeout; }
+        bool isPrefilterEnabled() const { return mPrefilter; }
+        bool isTraceEnabled() const { return mTrace; }
+        bool isMemoryReportEnabled() const { return mMemoryReport > 0; }
+        size_t getMemoryReportCount() const { return mMemoryReport; }
         
     protected:
         std::string                 mOutputDirectory;
         std::string                 mInputDirectory;
         std::string                 mLicense;
+        std::string                 mScriptDirectory;
         
         std::vector<std::string>    mInputFileList;
         std::vector<std::string>    mExcludeFileList;
@@ -225,17 +314,328 @@ public:
         std::vector<std::string>    mUnsupportedTypes;
         
         std::map<std::string,std::string> mSupportedOperators;
+        
+        bool                        mTableRegistration;
+        bool                        mRegistrationUnits;
+        bool                        mThreadSafeFactories;
+        bool                        mPooledFactories;
+        bool                        mThreadLocalPools;
+        bool                        mRegistrationProfiling;
+        bool                        mCallCounters;
+        bool                        mAccessorProperties;
+        bool                        mVectorViews;
+        bool                        mStringWrappers;
+        bool                        mRegistrarEmitter;
+        bool                        mIncremental;
+        bool                        mDepfiles;
+        size_t                      mShardIndex;
+        size_t                      mShardCount;
+        bool                        mMerge;
+        size_t                      mWorkers;
+        size_t                      mWorkerJobs;
+        size_t                      mWorkerMemoryLimit;
+        double                      mWorkerTimeout;
+        bool                        mPrefilter;
+        bool                        mTrace;
+        size_t                      mMemoryReport;
+    };
+    
+    struct Output;
+    
+    //! an include directive met while parsing a header, the includer is empty for the parsed header itself
+    struct IncludeEdge {
+        std::string mIncluder;
+        std::string mIncluded;
+        std::string mPath;
+    };
+    
+    //! the memory used to parse a header, in bytes
+    struct HeaderMemory {
+        HeaderMemory() : mRssBefore( 0 ), mRssAfter( 0 ), mAstBytes( 0 ), mSideTableBytes( 0 ), mSourceMallocBytes( 0 ), mSourceMmapBytes( 0 ), mSourceTableBytes( 0 ), mOutputBytes( 0 ) {}
+        
+        //! returns the bytes allocated by clang for the header
+        size_t getClangBytes() const { return mAstBytes + mSideTableBytes + mSourceMallocBytes + mSourceMmapBytes + mSourceTableBytes; }
+        
+        size_t                          mRssBefore;
+        size_t                          mRssAfter;
+        size_t                          mAstBytes;
+        size_t                          mSideTableBytes;
+        size_t                          mSourceMallocBytes;
+        size_t                          mSourceMmapBytes;
+        size_t                          mSourceTableBytes;
+        size_t                          mOutputBytes;
+        //! the size of every section of the output
+        std::map<std::string,size_t>    mSections;
+    };
+    
+    //! what a header adds to the files shared by every header, kept with the include graph between runs
+    struct HeaderRecord {
+        HeaderRecord() : mHasDeclarations( false ), mHasDefinitions( false ), mHasTemplates( false ), mParseTime( 0 ), mVisitTime( 0 ), mEmitTime( 0 ) {}
+        
+        std::string                 mPath;
+        std::string                 mName;
+        std::string                 mHeader;
+        std::string                 mOutputPath;
+        bool                        mHasDeclarations;
+        bool                        mHasDefinitions;
+        bool                        mHasTemplates;
+        std::vector<std::string>    mTypes;
+        std::set<std::string>       mDependencies;
+        std::vector<std::string>    mCountedBindings;
+        std::set<std::string>       mTemplateInstantiations;
+        std::vector<IncludeEdge>    mIncludes;
+        std::map<std::string,std::pair<std::string,std::string>> mVectorViews;
+        std::set<std::string>       mFactoryTypes;
+        std::set<std::string>       mEscapingTypes;
+        
+        //! the seconds spent by clang, by the visitor and writing the bindings of the header
+        double                      mParseTime;
+        double                      mVisitTime;
+        double                      mEmitTime;
+        HeaderMemory                mMemory;
+    };
+    
+    //! the headers returned by parse, the headers reused from a previous run or a shard only have a record
+    struct Model {
+        std::vector<HeaderRecord>                       mRecords;
+        std::map<std::string,std::shared_ptr<Output>>   mOutputs;
+        //! the shards files the records were read from, by path relative to the output directory
+        std::vector<std::string>                        mMergedShards;
+        //! the modification time of the files the records were parsed from, read when they were parsed
+        std::map<std::string,std::time_t>               mFileStamps;
+        //! the bindings written by the workers, by path relative to the output directory
+        std::map<std::string,std::string>               mFiles;
+        //! every header given to parse by canonical path, the skipped and failed ones included
+        std::vector<std::string>                        mHeaders;
+        //! the headers that crashed or timed out in every worker they were given to
+        std::vector<std::string>                        mFailedHeaders;
+        //! the headers the prefilter found without declarations
+        std::vector<std::string>                        mSkippedHeaders;
+    };
+    
+    //! receives the generated files, the paths are relative to the output directory
+    class Sink {
+    public:
+        virtual ~Sink() {}
+        virtual void write( const std::string &path, const std::string &content ) = 0;
+        virtual bool exists( const std::string &path ) const = 0;
+        virtual void remove( const std::string &path ) = 0;
     };
     
+    //! writes the generated files in a directory
+    class FileSink : public Sink {
+    public:
+        explicit FileSink( const std::string &directory ) : mDirectory( directory ) {}
+        
+        void write( const std::string &path, const std::string &content ) override;
+        bool exists( const std::string &path ) const override;
+        void remove( const std::string &path ) override;
+    
+    protected:
+        std::string mDirectory;
+    };
+    
+    //! keeps the generated files in memory, a file written again replaces the previous one
+    class MemorySink : public Sink {
+    public:
+        void write( const std::string &path, const std::string &content ) override { mFiles[path] = content; }
+        bool exists( const std::string &path ) const override { return mFiles.count( path ) > 0; }
+        void remove( const std::string &path ) override { mFiles.erase( path ); }
+        
+        const std::map<std::string,std::string>& getFiles() const { return mFiles; }
+    
+    protected:
+        std::map<std::string,std::string> mFiles;
+    };
+    
+#if defined( CLANG_PARSER_BENCHMARKS )
+    //! The string helpers of the Visitor on the declarations of an AST, called outside of a run. Only
+    //! the benchmarks use it, they are built with CLANG_PARSER_BENCHMARKS defined
+    class VisitorHelpers {
+    public:
+        VisitorHelpers( clang::ASTContext* context, const Options &options );
+        ~VisitorHelpers();
+        
+        //! adds a namespace alias the names are written with
+        void addNamespaceAlias( clang::NamespaceAliasDecl *alias );
+        
+        std::string getTypeName( const clang::QualType &type );
+        std::string getTypeQualifiedName( const clang::QualType &type );
+        std::string getDeclarationQualifiedName( clang::NamedDecl *declaration );
+        std::string getFunctionArgList( clang::FunctionDecl *function );
+        std::string styleScopedName( const std::string &name );
+        std::string replaceNamespacesByAliases( const std::string &name );
+        bool isSupported( const std::string &name );
+    
+    protected:
+        //! the Visitor and the output and usage it writes to, defined with the Visitor
+        struct Fixture;
+        std::unique_ptr<Fixture> mFixture;
+    };
+#endif
+    
+    //! the clang setup, the scripts symbols and the headers records are kept between the calls
     Parser( Options options = Options() );
     
+    //! parses every header and writes the bindings in the output directory
+    void run();
+    //! returns the input file list, or the headers found in the input directory
+    std::vector<std::string> findHeaders() const;
+    //! parses the headers, reusing the ones the include graph or the shards records allow to skip
+    Model parse( const std::vector<std::string> &files );
+    //! writes the bindings of the parsed headers and the files shared by every header
+    void emit( const Model &model, Sink &sink );
+    
+    //! returns the files that include one of the changed files, directly or through other headers, including the changed files
+    std::set<std::string> getInvalidatedHeaders( const std::set<std::string> &changedFiles ) const;
+
 protected:
+    //! the registration functions generated for a header
+    struct Unit {
+        std::string             mName;
+        std::string             mHeader;
+        std::string             mPath;
+        bool                    mHasDeclarations;
+        bool                    mHasDefinitions;
+        std::vector<std::string> mTypes;
+        std::set<std::string>   mDependencies;
+    };
+    
+    //! symbols reachable from a script corpus, used to only emit the bindings the scripts need
+    struct Usage {
+        Usage() : mEnabled( false ) {}
+        
+        //! returns whether a script type should be bound
+        bool isTypeUsed( const std::string &type ) const { return !mEnabled || mTypes.count( type ); }
+        //! returns whether a class member should be bound
+        bool isMemberUsed( const std::string &type, const std::string &member ) const { return !mEnabled || ( mTypes.count( type ) && isMemberReferenced( type, member ) ); }
+        //! returns whether a global function, an enum value or a class member is referenced by the scripts
+        bool isIdentifierUsed( const std::string &identifier ) const { return !mEnabled || mIdentifiers.count( identifier ); }
+        //! returns whether the scripts can reach a member, constructors and operators are kept with their class
+        bool isMemberReferenced( const std::string &type, const std::string &member ) const { return member == type || member.find( "operator" ) == 0 || mIdentifiers.count( member ); }
+        
+        //! adds the identifiers of a script or a declaration, skipping comments, strings and numbers
+        static void tokenize( const std::string &code, std::set<std::string> *identifiers );
+        //! returns a key identifying the headers the types are collected from
+        static std::string getInputsKey( const std::vector<boost::filesystem::path> &inputs );
+        
+        bool                    mEnabled;
+        std::set<std::string>   mIdentifiers;
+        std::set<std::string>   mTypes;
+        //! the modification time of the scripts and the key of the headers the usage was collected from
+        std::map<std::string,std::time_t>   mScripts;
+        std::string             mInputsKey;
+    };
+    
+    //! the declarations of a header the usage follows, kept with the modification time of every file
+    //! the header read so it is only parsed again for the usage once one of them changed
+    struct HeaderSymbols {
+        std::map<std::string,std::time_t>   mFiles;
+        //! the members of every class, by class name, with the types of their signature
+        std::map<std::string,std::vector<std::pair<std::string,std::string>>>  mClasses;
+        std::map<std::string,std::string>   mTemplateTypedefs;
+        //! the enums and their values
+        std::vector<std::pair<std::string,std::vector<std::string>>>           mEnums;
+        //! the functions and the types of their signature
+        std::vector<std::pair<std::string,std::string>>                        mFunctions;
+    };
+    
+    //! a registration call stored in a binding table instead of being written as an unrolled call
+    struct BindingTableEntry {
+        std::string mKind;
+        std::string mNamespace;
+        std::string mObject;
+        std::string mDeclaration;
+        std::string mFunction;
+        std::string mCallConv;
+        std::string mBehaviour;
+        bool        mIsCommented;
+    };
+    
+    //! the times recorded for a header, used to start the most expensive headers first
+    struct HeaderTiming {
+        HeaderTiming() : mSize( 0 ), mParseTime( 0 ), mVisitTime( 0 ), mEmitTime( 0 ) {}
+        
+        uintmax_t   mSize;
+        double      mParseTime;
+        double      mVisitTime;
+        double      mEmitTime;
+    };
+    
+    //! a span of the generator timeline, the times are in microseconds of a clock shared by the workers
+    struct TraceEvent {
+        std::string mName;
+        std::string mCategory;
+        std::string mHeader;
+        double      mStart;
+        double      mDuration;
+        int         mProcess;
+        size_t      mThread;
+    };
+    
+    //! the spans recorded by a process, the current header tags the spans added while it's processed
+    struct Trace {
+        Trace() : mEnabled( false ) {}
+        
+        //! returns the current time in microseconds
+        static double now();
+        //! adds a span to the timeline
+        void add( const std::string &name, const std::string &category, double start, double duration );
+        
+        bool                    mEnabled;
+        std::string             mHeader;
+        std::vector<TraceEvent> mEvents;
+    };
+    
+    //! records the span of its scope when the trace is enabled
+    class TraceSpan {
+    public:
+        TraceSpan( Trace* trace, const char* name, const char* category ) : mTrace( trace && trace->mEnabled ? trace : nullptr ), mName( name ), mCategory( category ), mStart( mTrace ? Trace::now() : 0 ) {}
+        ~TraceSpan() { if( mTrace ) mTrace->add( mName, mCategory, mStart, Trace::now() - mStart ); }
+    
+    private:
+        Trace*      mTrace;
+        const char* mName;
+        const char* mCategory;
+        double      mStart;
+    };
+    
+    //! forwards the files to another sink and traces their writes
+    class TraceSink : public Sink {
+    public:
+        TraceSink( Sink &sink, Trace* trace ) : mSink( sink ), mTrace( trace ) {}
+        
+        void write( const std::string &path, const std::string &content ) override;
+        bool exists( const std::string &path ) const override { return mSink.exists( path ); }
+        void remove( const std::string &path ) override { mSink.remove( path ); }
+    
+    protected:
+        Sink&   mSink;
+        Trace*  mTrace;
+    };
+    
+    //! a class registration function timed by the profiling probes
+    struct ProfileEntry {
+        std::string mClass;
+        std::string mFunction;
+    };
+    
+public:
+    //! the model and the generated code of a header, available to the users of parse
     struct Output {
-        Output() : mIsInNamespace(false) {}
+        Output() : mIsInNamespace(false), mHasSharedRefs(false), mVisitTime(0), mTrace(nullptr), mParseStart(0) { mBindingStrings.push_back( "" ); mBindingStringsIndices[""] = 0; }
+        
+        //! returns the index of a string in the translation unit string table, adding it if needed
+        uint32_t getBindingStringIndex( const std::string &str );
+        //! returns the number of uncommented registration calls and binding table entries in generated code
+        static size_t countRegistrationCalls( const std::string &code );
+        //! returns the number of uncommented registration calls and binding table entries read from a stream
+        static size_t countRegistrationCalls( std::istream &stream );
         
         std::stringstream   mClassDecl;
         std::stringstream   mClassDef;
         std::stringstream   mClassExtras;
+        std::stringstream   mWrappers;
         std::stringstream   mClassFieldDecl;
         std::stringstream   mClassFieldDef;
         std::stringstream   mClassMethodDecl;
@@ -243,7 +643,7 @@ protected:
         
         std::stringstream   mTemplatesDecl;
         std::stringstream   mTemplatesDef;
-        std::stringstream   mTemplatesSpec;
+        std::stringstream   mTemplatesExtras;
         std::stringstream   mTemplateDeclCalls;
         
         std::stringstream   mEnumsDecl;
@@ -265,8 +665,50 @@ protected:
         std::vector<ClassRef>       mClasses;
         std::vector<EnumRef>        mEnums;
         std::vector<FunctionRef>    mFunctions;
+        
+        std::vector<std::string>        mBindingStrings;
+        std::map<std::string,uint32_t>  mBindingStringsIndices;
+        
+        std::vector<std::string>        mDeclaredTypes;
+        std::set<std::string>           mDependencies;
+        
+        std::map<std::string,std::string> mTemplateTypedefs;
+        //! explicit instantiations of the templates registration functions, declared extern by the generated header
+        std::set<std::string>           mTemplateInstantiations;
+        
+        std::vector<ProfileEntry>       mProfileEntries;
+        std::map<std::string,size_t>    mRegistrationCounts;
+        
+        //! the constant the ids of the counted bindings are offset by, its value is assigned when the shared files are emitted
+        std::string                     mBindingIdBase;
+        std::vector<std::string>        mCountedBindings;
+        
+        //! the vector views used by the header, script name to C++ and script element types
+        std::map<std::string,std::pair<std::string,std::string>> mVectorViews;
+        std::set<std::string>           mWrappersNames;
+        
+        //! whether the header registers Ref typedefs
+        bool                            mHasSharedRefs;
+        
+        //! the unique names of the classes with a factory choosing its reference count, and of the classes
+        //! the scripts can get without their factory, as references, pointers or properties
+        std::set<std::string>           mFactoryTypes;
+        std::set<std::string>           mEscapingTypes;
+        
+        std::vector<IncludeEdge>        mIncludes;
+        //! the seconds spent visiting the translation unit
+        double                          mVisitTime;
+        
+        //! the trace of the parser, null when it's disabled, and the time clang started parsing the header
+        Trace*                          mTrace;
+        double                          mParseStart;
+        
+        //! the memory used by clang, measured once the translation unit is visited
+        HeaderMemory                    mMemory;
     };
     
+protected:
+    
     
     
     
@@ -275,7 +717,7 @@ protected:
     class Visitor : public clang::RecursiveASTVisitor<Visitor> {
     public:
         //! constructor
-        Visitor( clang::ASTContext* context, Output& output, const Options& options ) : mContext(context), mOutput(output), mOptions(options) {}
+        Visitor( clang::ASTContext* context, Output& output, const Options& options, const Usage& usage ) : mContext(context), mOutput(output), mOptions(options), mUsage(usage) {}
         
         //! visits exceptions
         bool VisitCXXThrowExpr(clang::CXXThrowExpr *expr);
@@ -297,6 +739,21 @@ protected:
         //! stops implicit code visits
         bool shouldVisitImplicitCode() const { return false; }
         
+        //! returns the qualified/scoped name of a Declaration
+        std::string getDeclarationQualifiedName( clang::NamedDecl* declaration );
+        //! returns the name of a QualType
+        std::string getTypeName( const clang::QualType &type );
+        //! returns the qualified/scoped name of a QualType
+        std::string getTypeQualifiedName( const clang::QualType &type );
+        //! returns the list of argument name of a function
+        std::string getFunctionArgList( clang::FunctionDecl *function );
+        //! replaces namespaces by aliases and returns the corrected string
+        std::string replaceNamespacesByAliases( const std::string &declaration );
+        //! makes each word first char upper case, removes the :: and returns the styled string
+        std::string styleScopedName( const std::string &declaration );
+        //! returns wether a string contains unsupported types
+        bool isSupported( const std::string& expr );
+    
     private:
         //! returns the full declaration as a string
         template<typename T>
@@ -318,14 +775,12 @@ protected:
         std::string getDeclarationName( clang::NamedDecl* declaration );
         //! returns the name of a Declaration
         std::string getDeclarationName( const clang::NamedDecl* declaration );
-        //! returns the qualified/scoped name of a Declaration
-        std::string getDeclarationQualifiedName( clang::NamedDecl* declaration );
-        //! returns the name of a QualType
-        std::string getTypeName( const clang::QualType &type );
-        //! returns the qualified/scoped name of a QualType
-        std::string getTypeQualifiedName( const clang::QualType &type );
-        //! returns the list of argument name of a function
-        std::string getFunctionArgList( clang::FunctionDecl *function );
+        //! returns the type, name and default value of an argument
+        std::string getFunctionArg( clang::ParmVarDecl *parameter );
+        //! returns the list of argument of a function as declared to the scripts
+        std::string getScriptArgList( clang::FunctionDecl *function );
+        //! returns an argument as declared to the scripts, strings taken by const reference are input references
+        std::string getScriptArg( clang::ParmVarDecl *parameter );
         //! returns the qualified/scoped list of argument type name of a function
         std::string getFunctionArgTypeList( clang::FunctionDecl *function );
         //! returns the qualified/scoped list of argument names of a function
@@ -337,33 +792,88 @@ protected:
         //! returns the unique name of a declaration
         std::string getMangleName( clang::NamedDecl *declaration );
         
-        //! replaces namespaces by aliases and returns the corrected string
-        std::string replaceNamespacesByAliases( const std::string &declaration );
-        //! makes each word first char upper case, removes the :: and returns the styled string
-        std::string styleScopedName( const std::string &declaration );
         //! returns quoted string
         std::string quote( const std::string &declaration );
         
+        //! returns whether the factories keep the reference count with the object
+        bool hasIntrusiveRefCount() const;
+        //! returns the reference count used by the factories of that type, intrusive for the types only they create
+        std::string getRefCountedType( const std::string &qualifiedName, bool isFactoryOnly );
+        //! records the class of a type the scripts can reach without its factory creating it
+        void addEscapingType( const clang::QualType &type );
+        
+        //! writes a call to a class registration function, wrapped in a timing probe when profiling
+        void writeRegistrationCall( std::stringstream &stream, const std::string &className, const std::string &function, const std::string &arguments );
+        //! stores the number of registrations written to a stream since a position
+        void countRegistrations( std::stringstream &stream, std::streampos start, const std::string &function );
+        //! removes the result declaration of the registration function written since a position if none of its calls assigns it
+        static void removeUnusedResult( std::stringstream &stream, std::streampos start );
+        
+        //! returns the pointer passed to the registrar, cast to its signature if the function is overloaded
+        std::string getRegistrarPointer( clang::FunctionDecl *function, const std::string &qualifiedName, const std::string &signature );
+        
+        //! returns the counting wrapper registered instead of a method or a function and adds it to the counted bindings
+        std::string getCountedBinding( const std::string &wrapper, const std::string &signature, const std::string &function, const std::string &name );
+        //! adds a counted binding and returns its id, an offset from the base of the header
+        std::string addCountedBinding( const std::string &name );
+        
+        //! writes a binding table and the call registering it
+        void writeBindingTable( std::stringstream &stream, std::vector<BindingTableEntry> &entries );
+        
         
         clang::DeclContext* getTypeDeclContext( const clang::QualType& type );
+        //! records the header declaring a type if it's not the main file
+        void addTypeDependency( const clang::QualType& type );
+        //! records the headers declaring the return and parameter types of a function
+        void addFunctionDependencies( clang::FunctionDecl *function );
         
-        //! returns wether a string contains unsupported types
-        bool isSupported( const std::string& expr );
+        //! returns the field of the class a method returns or assigns if its body does nothing else
+        clang::FieldDecl* getTrivialAccessorField( clang::CXXMethodDecl *method, bool *isSetter );
+        //! returns the property name of an accessor, getR and setR give r, or an empty string
+        std::string getAccessorPropertyName( const std::string &methodName, bool isSetter );
+        
+        //! returns the class a Ref typedef of a bound header points to, or null if the type isn't one
+        clang::CXXRecordDecl* getSharedRefRecord( const clang::QualType &type );
+        //! returns whether the header declaring a Ref typedef registers it, only the used typedefs outside of the classes are
+        bool isSharedRefRegistered( clang::TypedefNameDecl *declaration );
+        //! marks the Ref typedef of a type as supported if its header registers it, by its name and its qualified names
+        void addSharedRef( const clang::QualType &type );
+        //! marks the Ref typedefs used by the return and parameter types of a function as supported
+        void addFunctionSharedRefs( clang::FunctionDecl *function );
+        
+        //! returns whether a type is a std::string, ignoring its qualifiers
+        bool isStdString( const clang::QualType &type );
+        //! returns whether a type is a const char pointer
+        bool isCString( const clang::QualType &type );
+        //! returns the element type of a std::vector passed by value or const reference, or a null type
+        clang::QualType getVectorElementType( const clang::QualType &type, bool *isConstReference );
+        //! returns the script name of the view of a vector element type and adds it to the views, or an empty string if it can't be viewed
+        std::string getVectorViewType( const clang::QualType &elementType, std::map<std::string,std::pair<std::string,std::string>> *views );
+        //! returns the script name of an arithmetic type, int8 to uint64, float or double, or an empty string if the scripts have none
+        std::string getScriptArithmeticType( const clang::QualType &type );
+        //! writes a wrapper passing the std::vector arguments and return value of a function as views and its
+        //! string arguments by reference, returns false if the function doesn't need one or can't have one
+        bool writeWrapper( clang::FunctionDecl *function, const std::string &factory, const std::string &name, const std::string &returnType, std::string *wrapperName, std::string *declaration );
         
         std::vector<std::string> visitedRecords;
+        //! the names of the Ref typedefs bound as value types
+        std::set<std::string>    mSharedRefNames;
         
         clang::ASTContext*                                  mContext;
         Output&                                             mOutput;
         const Options&                                      mOptions;
+        const Usage&                                        mUsage;
         std::map<std::string,clang::NamespaceAliasDecl*>    mNamespaceAliases;
         clang::CXXRecordDecl*                               mExceptionDecl;
+        //! created by the first mangled name and shared by the next ones
+        std::unique_ptr<clang::MangleContext>               mMangleContext;
     };
     
     // consumer class
     class Consumer : public clang::ASTConsumer {
     public:
         //! constructor
-        Consumer( clang::ASTContext* context, Output& output, const Options& options ) : mVisitor(context, output, options), mOutput(output) {}
+        Consumer( clang::ASTContext* context, Output& output, const Options& options, const Usage& usage ) : mVisitor(context, output, options, usage), mOutput(output) {}
         
         //! parses each top-level declarations
         //bool HandleTopLevelDecl(clang::DeclGroupRef group) override;
@@ -401,7 +911,7 @@ protected:
     class FrontendAction : public clang::ASTFrontendAction {
     public:
         //! constructor
-        FrontendAction( Output& output, const Options& options ) : mOutput(output), mOptions(options) {}
+        FrontendAction( Output& output, const Options& options, const Usage& usage ) : mOutput(output), mOptions(options), mUsage(usage) {}
         
         void EndSourceFileAction() override;
         
@@ -412,9 +922,120 @@ protected:
     private:
         Output&         mOutput;
         const Options&  mOptions;
+        const Usage&    mUsage;
     };
     
-    Options         mOptions;
+    //! returns whether a header declares a class, an enum, a function or a typedef itself, the includes aren't followed
+    static bool hasDeclarations( const std::string &code );
+    //! returns whether a registration code assigns the result of a call, the commented calls don't
+    static bool assignsResult( const std::string &code );
+    //! returns the path of the generated files of a header, without extension and relative to the output directory
+    std::string getOutputPath( const boost::filesystem::path &path ) const;
+    //! returns whether the previous run files of a header can be reused, nothing it includes changed and its files still exist
+    bool isReusable( const boost::filesystem::path &path, const std::set<std::string> &invalidatedHeaders ) const;
+    //! parses a header and returns its record, the output keeps the generated code until it is written
+    HeaderRecord parseHeader( const boost::filesystem::path &path, std::shared_ptr<Output> *output );
+    //! parses the headers in forked workers, a crashed or timed out header is retried once before being reported as failed
+    void parseInWorkers( const std::vector<boost::filesystem::path> &headers, std::map<std::string,HeaderRecord> *records, std::set<std::string> *failedHeaders, std::map<std::string,std::string> *files );
+    //! returns the constant the ids of the counted bindings of a header are offset by
+    static std::string getBindingIdBase( const std::string &name );
+    //! parses the headers sent by the parent process and sends back their bindings until its jobs pipe is closed
+    void runWorker( const std::vector<boost::filesystem::path> &headers, int jobs, int results );
+    
+    //! writes the bindings of a parsed header
+    void writeHeader( const HeaderRecord &record, Output &output, Sink &sink );
+    //! runs a frontend action on a header, like runToolOnCodeWithArgs but sharing the file manager between the headers
+    bool runTool( clang::FrontendAction* action, const std::string &code, const std::string &fileName );
+    
+    //! writes the registration units table and its dependencies
+    void writeRegistrationUnits( Sink &sink );
+    //! writes the counters array and the names of the counted bindings
+    void writeBindingCounters( Sink &sink );
+    //! writes the registration of the vector views used by the bindings
+    void writeVectorViews( Sink &sink );
+    //! writes the translation unit instantiating every template registration function
+    void writeTemplateInstantiations( Sink &sink );
+    //! writes the macros telling the factories which types only they create
+    void writeFactoryTypes( Sink &sink );
+    
+    //! adds what a header contributes to the shared files and to the global registration calls
+    void addHeaderRecord( const HeaderRecord &record, std::stringstream &globalIncludes, std::stringstream &globalDeclCalls, std::stringstream &globalDefCalls );
+    //! reads an include graph and its headers records, written by a previous run or by a shard
+    void readIncludeGraph( const std::string &path );
+    //! returns the modification time of every file the records depend on
+    static std::map<std::string,std::time_t> getFileStamps( const std::vector<HeaderRecord> &records );
+    //! keeps the modification time of every file the emitted headers depend on, as they were when parsed
+    void updateFileStamps( const Model &model );
+    //! reads the parse, visit and emit times of the headers recorded by the previous runs
+    void readTimings();
+    //! adds the times of the headers parsed by this run to the history and writes it
+    void writeTimings( Sink &sink );
+    //! returns the mean cost per byte of the recorded headers
+    double getCostPerByte() const;
+    //! returns the recorded cost of a header, or an estimate from its size and the cost per byte of the recorded headers
+    double getEstimatedCost( const boost::filesystem::path &path, double costPerByte ) const;
+    //! writes the chrome trace of the run and prints the time spent in every phase and by the most expensive headers
+    void writeTrace( const std::string &path, Sink &sink );
+    //! prints the memory used by the most memory hungry headers
+    void printMemoryReport() const;
+    //! returns the current resident memory of the process in bytes
+    static size_t getResidentMemory();
+    //! writes the include graph, the headers records and the modification time of every file of the graph
+    void writeIncludeGraph( const std::string &path, Sink &sink );
+    //! returns the records of the model and the previous records of the input headers the model doesn't have
+    std::vector<HeaderRecord> getMergedRecords( const Model &model, const Sink &sink ) const;
+    //! writes a header record, one line per field with its kind first, the record starts with its header line
+    static void writeHeaderRecord( std::ostream &stream, const HeaderRecord &record );
+    //! reads a line of a header record and returns the record the next lines belong to
+    static HeaderRecord* readHeaderRecordLine( const std::vector<std::string> &fields, std::map<std::string,HeaderRecord> &records, HeaderRecord* record );
+    //! writes the symbols of a header, they start with their symbols line and use the same format as the records
+    static void writeHeaderSymbols( std::ostream &stream, const std::string &path, const HeaderSymbols &symbols );
+    //! reads a line of the symbols of a header and returns the symbols the next lines belong to
+    static HeaderSymbols* readHeaderSymbolsLine( const std::vector<std::string> &fields, std::map<std::string,HeaderSymbols> &symbols, HeaderSymbols* headerSymbols );
+    //! returns the headers of the current shard, balanced by size and independent of the node running it
+    std::set<std::string> getShardHeaders( const std::vector<boost::filesystem::path> &inputs ) const;
+    //! writes the registry calling the registration functions of every header
+    void writeRegistry( const std::string &includes, const std::string &declCalls, const std::string &defCalls, Sink &sink );
+    //! returns the files of the previous run graph modified or removed since
+    std::set<std::string> getChangedFiles() const;
+    //! returns a string identifying the options changing the generated files
+    std::string getOptionsKey() const;
+    //! writes the depfiles of every header and the one of the whole run
+    void writeDepfiles( const Model &model, Sink &sink );
+    //! writes a depfile listing the files the targets depend on
+    void writeDepfile( const std::string &path, const std::vector<std::string> &targets, const std::set<std::string> &dependencies, Sink &sink );
+    //! collects the identifiers of the scripts and the types they reach through the headers model
+    void collectUsage( const std::vector<boost::filesystem::path> &inputs );
+    //! returns the symbols of a header, from the previous runs if none of the files it read changed
+    HeaderSymbols getHeaderSymbols( const boost::filesystem::path &path, std::map<std::string,std::time_t> &stamps );
+    //! returns the modification time of every script of the script directory
+    std::map<std::string,std::time_t> getScriptStamps() const;
+    
+    Options             mOptions;
+    Usage               mUsage;
+    std::vector<Unit>   mUnits;
+    std::vector<std::string> mCountedBindings;
+    std::map<std::string,std::pair<std::string,std::string>> mVectorViews;
+    std::set<std::string>   mVectorViewsHeaders;
+    std::set<std::string>   mFactoryTypes;
+    std::set<std::string>   mEscapingTypes;
+    std::set<std::string>   mTemplateInstantiations;
+    //! the headers and templates definitions included by the instantiations translation unit
+    std::vector<std::string> mTemplatesHeaders;
+    std::vector<std::string> mTemplatesInlines;
+    
+    //! the records of this run and of the previous one, by canonical header path
+    std::vector<HeaderRecord>           mRecords;
+    std::map<std::string,HeaderRecord>  mCachedRecords;
+    //! the usage of the previous run, reused while neither the scripts nor the headers changed
+    Usage                               mCachedUsage;
+    //! the symbols of every header the usage was collected from, they don't depend on the scripts
+    std::map<std::string,HeaderSymbols> mCachedSymbols;
+    std::map<std::string,std::time_t>   mFileStamps;
+    
+    llvm::IntrusiveRefCntPtr<clang::FileManager> mFileManager;
+    std::map<std::string,HeaderTiming>  mTimings;
+    Trace                               mTrace;
 };
 
 
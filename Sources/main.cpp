@@ -1,5 +1,7 @@
 #include "Parser.h"
 
+#include <iostream>
+
 int main(int argc, const char * argv[])
 {
     Parser::Options options;
@@ -221,7 +223,30 @@ POSSIBILITY OF SUCH DAMAGE.\n\
     })
     ;
     
+    // --shard index/count only parses a part of the headers, --merge then writes the shared files of every shard,
+    // --workers count parses the headers in crash isolated processes
+    for( int i = 1; i < argc; i++ ){
+        std::string argument = argv[i];
+        if( argument == "--shard" && i + 1 < argc ){
+            std::stringstream shard( argv[++i] );
+            size_t index, count;
+            char separator;
+            if( !( shard >> index >> separator >> count ) || separator != '/' || index >= count ){
+                std::cerr << "usage: --shard index/count, with index in [0, count)" << std::endl;
+                return 1;
+            }
+            options.shard( index, count );
+        }
+        else if( argument == "--merge" ){
+            options.merge();
+        }
+        else if( argument == "--workers" && i + 1 < argc ){
+            options.workers( std::stoul( argv[++i] ) ).workerTimeout( 300 );
+        }
+    }
+    
     Parser parser( options );
+    parser.run();
     
     
     return 0;